@@ -0,0 +1,323 @@
+#pragma once
+#include <bitset>
+#include <string_view>
+#include <vector>
+#include <winmd_reader.h>
+#include "platform.h"
+#include "metadata_index.h"
+#include "snapshot.h"
+
+using namespace winmd::reader;
+
+/// The attributes the projection cares about, anything else is left in the metadata
+enum class known_attribute : uint8_t {
+    exclusive_to,
+    webhost_hidden,
+    activatable,
+    flags,
+    no_exception,
+    api_contract,
+    default_interface,
+    guid,
+    overload,
+    static_interface,
+    count
+};
+
+using attribute_set = std::bitset<static_cast<size_t>(known_attribute::count)>;
+
+/// One ActivatableAttribute, `factory` is empty when the type is default constructible
+struct activation_factory {
+    std::string_view factory;
+    uint32_t version = 0;
+};
+
+struct type_attributes {
+    attribute_set flags;
+    winrt::guid guid{};
+    std::vector<std::string_view> statics; // the interfaces named by StaticAttribute
+    std::vector<activation_factory> factories;
+};
+
+struct method_attributes {
+    attribute_set flags;
+    std::string_view overload; // the name given by OverloadAttribute
+};
+
+/// The known attributes of every type, method, property and interface implementation in a
+/// database, decoded in a single pass over its CustomAttribute table
+class attribute_table {
+public:
+    explicit attribute_table(database const& db) :
+        _types(db.TypeDef.size()),
+        _methods(db.MethodDef.size()),
+        _properties(db.Property.size()),
+        _interface_impls(db.InterfaceImpl.size()) {
+        for (auto&& attribute : db.CustomAttribute) {
+            auto kind = classify(attribute);
+            if (kind == known_attribute::count)
+                continue;
+
+            auto parent = attribute.Parent();
+            switch (parent.type()) {
+            case HasCustomAttribute::TypeDef:
+                decode(_types[parent.index()], kind, attribute);
+                break;
+            case HasCustomAttribute::MethodDef:
+                decode(_methods[parent.index()], kind, attribute);
+                break;
+            case HasCustomAttribute::Property:
+                _properties[parent.index()].set(static_cast<size_t>(kind));
+                break;
+            case HasCustomAttribute::InterfaceImpl:
+                _interface_impls[parent.index()].set(static_cast<size_t>(kind));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    /// Reads the table back from a snapshot, names point into the mapping
+    attribute_table(database const& db, snapshot_reader& in) : _snapshot(in.file()) {
+        auto [text, text_size] = in.read_array<char>();
+        auto view = [&, text = text, text_size = text_size](string_record const& r) {
+            if (r.offset + r.length > text_size)
+                throw std::runtime_error("snapshot doesn't match the database");
+
+            return std::string_view{ text + r.offset, r.length };
+        };
+
+        auto [types, type_count] = in.read_array<type_record>();
+        auto [statics, statics_count] = in.read_array<string_record>();
+        auto [factories, factory_count] = in.read_array<factory_record>();
+        auto [methods, method_count] = in.read_array<method_record>();
+        auto [properties, property_count] = in.read_array<uint32_t>();
+        auto [impls, impl_count] = in.read_array<uint32_t>();
+        if (type_count != db.TypeDef.size() || method_count != db.MethodDef.size() || property_count != db.Property.size() || impl_count != db.InterfaceImpl.size())
+            throw std::runtime_error("snapshot doesn't match the database");
+
+        _types.resize(type_count);
+        for (size_t i = 0; i < type_count; i++) {
+            auto& record = types[i];
+            if (record.statics_first + record.statics_count > statics_count || record.factories_first + record.factories_count > factory_count)
+                throw std::runtime_error("snapshot doesn't match the database");
+
+            auto& type = _types[i];
+            type.flags = attribute_set(record.flags);
+            type.guid = record.guid;
+            for (uint32_t n = 0; n < record.statics_count; n++) {
+                type.statics.push_back(view(statics[record.statics_first + n]));
+            }
+
+            for (uint32_t n = 0; n < record.factories_count; n++) {
+                auto& factory = factories[record.factories_first + n];
+                type.factories.push_back({ view(factory.name), factory.version });
+            }
+        }
+
+        _methods.resize(method_count);
+        for (size_t i = 0; i < method_count; i++) {
+            _methods[i].flags = attribute_set(methods[i].flags);
+            _methods[i].overload = view(methods[i].overload);
+        }
+
+        _properties.assign(properties, properties + property_count);
+        _interface_impls.assign(impls, impls + impl_count);
+    }
+
+    void save(snapshot_writer& out) const {
+        std::vector<char> text;
+        auto add = [&](std::string_view s) {
+            string_record r{ static_cast<uint32_t>(text.size()), static_cast<uint32_t>(s.size()) };
+            text.insert(text.end(), s.begin(), s.end());
+            return r;
+        };
+
+        std::vector<type_record> types;
+        std::vector<string_record> statics;
+        std::vector<factory_record> factories;
+        for (auto&& type : _types) {
+            type_record record{};
+            record.flags = static_cast<uint32_t>(type.flags.to_ulong());
+            record.guid = type.guid;
+            record.statics_first = static_cast<uint32_t>(statics.size());
+            record.statics_count = static_cast<uint32_t>(type.statics.size());
+            record.factories_first = static_cast<uint32_t>(factories.size());
+            record.factories_count = static_cast<uint32_t>(type.factories.size());
+            for (auto&& name : type.statics) {
+                statics.push_back(add(name));
+            }
+
+            for (auto&& factory : type.factories) {
+                factories.push_back({ add(factory.factory), factory.version });
+            }
+
+            types.push_back(record);
+        }
+
+        std::vector<method_record> methods;
+        for (auto&& method : _methods) {
+            methods.push_back({ static_cast<uint32_t>(method.flags.to_ulong()), add(method.overload) });
+        }
+
+        auto flags = [](std::vector<attribute_set> const& sets) {
+            std::vector<uint32_t> result;
+            for (auto&& set : sets) {
+                result.push_back(static_cast<uint32_t>(set.to_ulong()));
+            }
+
+            return result;
+        };
+
+        out.write_array(text);
+        out.write_array(types);
+        out.write_array(statics);
+        out.write_array(factories);
+        out.write_array(methods);
+        out.write_array(flags(_properties));
+        out.write_array(flags(_interface_impls));
+    }
+
+    type_attributes const& operator[](TypeDef const& row) const { return _types[row.index()]; }
+    method_attributes const& operator[](MethodDef const& row) const { return _methods[row.index()]; }
+    attribute_set const& operator[](Property const& row) const { return _properties[row.index()]; }
+    attribute_set const& operator[](InterfaceImpl const& row) const { return _interface_impls[row.index()]; }
+
+private:
+    static known_attribute classify(CustomAttribute const& attribute) {
+        auto [ns, name] = attribute.TypeNamespaceAndName();
+        if (ns == "System")
+            return name == "FlagsAttribute" ? known_attribute::flags : known_attribute::count;
+
+        if (ns != "Windows.Foundation.Metadata")
+            return known_attribute::count;
+
+        if (name == "ExclusiveToAttribute")
+            return known_attribute::exclusive_to;
+        if (name == "WebHostHiddenAttribute")
+            return known_attribute::webhost_hidden;
+        if (name == "ActivatableAttribute")
+            return known_attribute::activatable;
+        if (name == "NoExceptionAttribute")
+            return known_attribute::no_exception;
+        if (name == "ApiContractAttribute")
+            return known_attribute::api_contract;
+        if (name == "DefaultAttribute")
+            return known_attribute::default_interface;
+        if (name == "GuidAttribute")
+            return known_attribute::guid;
+        if (name == "OverloadAttribute")
+            return known_attribute::overload;
+        if (name == "StaticAttribute")
+            return known_attribute::static_interface;
+
+        return known_attribute::count;
+    }
+
+    static void decode(type_attributes& record, known_attribute kind, CustomAttribute const& attribute) {
+        record.flags.set(static_cast<size_t>(kind));
+
+        switch (kind) {
+        case known_attribute::guid: {
+            auto args = attribute.Value().FixedArgs();
+            auto get_arg = [&](size_t index) { return std::get<ElemSig>(args[index].value).value; };
+
+            record.guid.Data1 = std::get<uint32_t>(get_arg(0));
+            record.guid.Data2 = std::get<uint16_t>(get_arg(1));
+            record.guid.Data3 = std::get<uint16_t>(get_arg(2));
+            for (size_t i = 0; i < 8; i++) {
+                record.guid.Data4[i] = std::get<uint8_t>(get_arg(3 + i));
+            }
+            break;
+        }
+        case known_attribute::static_interface:
+            record.statics.push_back(system_type(attribute));
+            break;
+        case known_attribute::activatable: {
+            activation_factory factory;
+            factory.factory = system_type(attribute);
+            for (auto&& arg : attribute.Value().FixedArgs()) {
+                if (auto version = std::get_if<uint32_t>(&std::get<ElemSig>(arg.value).value)) {
+                    factory.version = *version;
+                    break;
+                }
+            }
+
+            record.factories.push_back(factory);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    static void decode(method_attributes& record, known_attribute kind, CustomAttribute const& attribute) {
+        record.flags.set(static_cast<size_t>(kind));
+
+        if (kind == known_attribute::overload)
+            record.overload = std::get<std::string_view>(std::get<ElemSig>(attribute.Value().FixedArgs()[0].value).value);
+    }
+
+    // the name of the first type argument, or nothing when there isn't one
+    static std::string_view system_type(CustomAttribute const& attribute) {
+        for (auto&& arg : attribute.Value().FixedArgs()) {
+            if (auto type_param = std::get_if<ElemSig::SystemType>(&std::get<ElemSig>(arg.value).value))
+                return type_param->name;
+        }
+
+        return {};
+    }
+
+    // how the table is laid out in a snapshot
+    struct string_record {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct type_record {
+        uint32_t flags;
+        uint32_t statics_first;
+        uint32_t statics_count;
+        uint32_t factories_first;
+        uint32_t factories_count;
+        winrt::guid guid;
+    };
+
+    struct factory_record {
+        string_record name;
+        uint32_t version;
+    };
+
+    struct method_record {
+        uint32_t flags;
+        string_record overload;
+    };
+
+    std::shared_ptr<mapped_file const> _snapshot;
+    std::vector<type_attributes> _types;
+    std::vector<method_attributes> _methods;
+    std::vector<attribute_set> _properties;
+    std::vector<attribute_set> _interface_impls;
+};
+
+template <typename T>
+auto const& attributes(T const& row) {
+    return database_index<attribute_table>::get(row.get_database())[row];
+}
+
+inline bool has_attribute(TypeDef const& row, known_attribute kind) {
+    return attributes(row).flags.test(static_cast<size_t>(kind));
+}
+
+inline bool has_attribute(MethodDef const& row, known_attribute kind) {
+    return attributes(row).flags.test(static_cast<size_t>(kind));
+}
+
+inline bool has_attribute(Property const& row, known_attribute kind) {
+    return attributes(row).test(static_cast<size_t>(kind));
+}
+
+inline bool has_attribute(InterfaceImpl const& row, known_attribute kind) {
+    return attributes(row).test(static_cast<size_t>(kind));
+}
@@ -0,0 +1,221 @@
+// Microbenchmarks for the functions that dominate a projection run.
+//
+//   tswinrt_bench <winmd>...
+//
+// Every benchmark walks the same rows of the given winmd files in the same order, is run once to
+// warm up and then a fixed number of times, and reports the median and fastest time per operation.
+// Compare numbers from the same corpus and machine only.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <winmd_reader.h>
+#include "../settings.h"
+#include "../writer.h"
+
+using namespace winmd::reader;
+
+namespace {
+    constexpr int repetitions = 9;
+
+    // results are folded in here so the optimiser can't drop the work being measured
+    uint64_t volatile g_sink;
+
+    template <typename T>
+    void consume(T const& value) {
+        g_sink = g_sink + static_cast<uint64_t>(value);
+    }
+
+    struct corpus {
+        std::vector<TypeDef> types;
+        std::vector<TypeDef> interfaces;
+        std::vector<std::pair<TypeDef, MethodDef>> class_methods;
+        std::vector<std::pair<MethodDef, MethodDef>> method_pairs;
+        std::vector<TypeSig> signatures;
+        std::vector<std::string_view> member_names;
+        std::vector<Field> fields;
+        std::vector<Param> params;
+        std::vector<MethodDef> methods;
+    };
+
+    corpus load_corpus(cache const& c) {
+        corpus result;
+        for (auto&& db : c.databases()) {
+            for (auto&& type : db.TypeDef) {
+                if (!type.Flags().WindowsRuntime())
+                    continue;
+
+                result.types.push_back(type);
+                auto category = get_category(type);
+                if (category == category::interface_type)
+                    result.interfaces.push_back(type);
+
+                // anything generic needs arguments in scope to be projected
+                if (is_ptype(type))
+                    continue;
+
+                for (auto&& field : type.FieldList()) {
+                    result.signatures.push_back(field.Signature().Type());
+                }
+
+                for (auto&& method : type.MethodList()) {
+                    auto signature = method.Signature();
+                    for (auto&& param : signature.Params()) {
+                        result.signatures.push_back(param.Type());
+                    }
+
+                    if (category == category::class_type)
+                        result.class_methods.emplace_back(type, method);
+                }
+            }
+
+            for (auto&& row : db.Field) {
+                result.member_names.push_back(row.Name());
+                result.fields.push_back(row);
+            }
+
+            for (auto&& row : db.Param) {
+                result.member_names.push_back(row.Name());
+                result.params.push_back(row);
+            }
+
+            for (auto&& row : db.MethodDef) {
+                result.member_names.push_back(row.Name());
+                result.methods.push_back(row);
+            }
+
+            for (auto&& row : db.Property) {
+                result.member_names.push_back(row.Name());
+            }
+
+            for (auto&& row : db.Event) {
+                result.member_names.push_back(row.Name());
+            }
+        }
+
+        for (auto&& [type, method] : result.class_methods) {
+            bool is_static = false;
+            if (auto iface_method = get_interface_method(type, method, is_static))
+                result.method_pairs.emplace_back(iface_method, method);
+        }
+
+        return result;
+    }
+
+    /// Runs `pass` (which performs `ops` operations) once to warm up, then `repetitions` times
+    template <typename F>
+    void run(char const* name, size_t ops, F&& pass) {
+        if (ops == 0) {
+            printf("%-36s %12s\n", name, "(no rows)");
+            return;
+        }
+
+        pass();
+
+        std::vector<double> samples;
+        for (int i = 0; i < repetitions; i++) {
+            auto start = std::chrono::steady_clock::now();
+            pass();
+            auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            samples.push_back(elapsed / ops);
+        }
+
+        std::sort(samples.begin(), samples.end());
+        printf("%-36s %10.1f ns/op  (min %8.1f, %zu ops)\n", name, samples[samples.size() / 2], samples.front(), ops);
+    }
+}
+
+int main(int argc, char const* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <winmd>...\n", argv[0]);
+        return 1;
+    }
+
+    settings settings;
+    settings.incremental = false;
+    for (int i = 1; i < argc; i++) {
+        settings.input.push_back(argv[i]);
+    }
+
+    cache c{ settings.input };
+    auto corpus = load_corpus(c);
+
+    // nothing is written, the writer is only here for its name projection
+    writer writer{ settings, std::filesystem::temp_directory_path() / "tswinrt-bench" };
+
+    printf("corpus: %zu types, %zu signatures, %zu member names, %zu class methods\n\n",
+        corpus.types.size(), corpus.signatures.size(), corpus.member_names.size(), corpus.class_methods.size());
+
+    run("get_type_semantics", corpus.signatures.size(), [&]() {
+        for (auto&& signature : corpus.signatures) {
+            consume(get_type_semantics(signature).index());
+        }
+    });
+
+    run("get_guid", corpus.interfaces.size(), [&]() {
+        for (auto&& type : corpus.interfaces) {
+            consume(get_guid(type).Data1);
+        }
+    });
+
+    run("get_interface_method", corpus.class_methods.size(), [&]() {
+        for (auto&& [type, method] : corpus.class_methods) {
+            bool is_static = false;
+            consume(get_interface_method(type, method, is_static).index());
+        }
+    });
+
+    run("are_equal", corpus.method_pairs.size(), [&]() {
+        for (auto&& [iface_method, method] : corpus.method_pairs) {
+            consume(are_equal(iface_method, method));
+        }
+    });
+
+    run("get_mapped_type", corpus.types.size(), [&]() {
+        for (auto&& type : corpus.types) {
+            consume(get_mapped_type(type.TypeNamespace(), type.TypeName()) != nullptr);
+        }
+    });
+
+    run("normalise_member_name", corpus.member_names.size(), [&]() {
+        std::string normalised;
+        for (auto&& name : corpus.member_names) {
+            normalised.clear();
+            normalise_member_name(name, normalised);
+            consume(normalised.size());
+        }
+    });
+
+    run("member_name (interned)", corpus.fields.size() + corpus.params.size() + corpus.methods.size(), [&]() {
+        for (auto&& row : corpus.fields) {
+            consume(member_name(row).size());
+        }
+
+        for (auto&& row : corpus.params) {
+            consume(member_name(row).size());
+        }
+
+        for (auto&& row : corpus.methods) {
+            consume(member_name(row).size());
+        }
+    });
+
+    run("projection_type_name", corpus.signatures.size(), [&]() {
+        for (auto&& signature : corpus.signatures) {
+            consume(writer.projection_type_name(get_type_semantics(signature), false, true).size());
+        }
+    });
+
+    // what tokenise_string used to do, splitting namespaces into their segments
+    run("for_each_segment", corpus.types.size(), [&]() {
+        for (auto&& type : corpus.types) {
+            size_t segments = 0;
+            for_each_segment(type.TypeNamespace(), [&](std::string_view segment) { segments += segment.size(); });
+            consume(segments);
+        }
+    });
+
+    return 0;
+}
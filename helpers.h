@@ -1,9 +1,15 @@
 #pragma once
+#include <map>
+#include <memory>
+#include <shared_mutex>
 #include <stack>
+#include <unordered_map>
 #include <algorithm>
 #include <cctype>
 #include <string>
 #include <winmd_reader.h>
+#include "attributes.h"
+#include "type_map.h"
 
 using namespace std::literals;
 using namespace winmd::reader;
@@ -30,7 +36,7 @@ auto call(V &&variant, C &&...call) {
 
 std::string get_mapped_element_type(ElementType elementType);
 
-void are_equal(const winmd::reader::MethodDef &iface_method, winmd::reader::MethodDef &method, int &retflag);
+bool are_equal(MethodDef const &iface_method, MethodDef const &method);
 
 static inline bool starts_with(std::string_view const &value, std::string_view const &match) noexcept {
     return 0 == value.compare(0, match.size(), match);
@@ -46,23 +52,23 @@ bool has_attribute(T const &row, std::string_view const &type_namespace, std::st
 }
 
 static bool is_noexcept(MethodDef const &method) {
-    return is_remove_overload(method) || has_attribute(method, "Windows.Foundation.Metadata", "NoExceptionAttribute");
+    return is_remove_overload(method) || has_attribute(method, known_attribute::no_exception);
 }
 
 static bool is_noexcept(Property const &prop) {
-    return has_attribute(prop, "Windows.Foundation.Metadata", "NoExceptionAttribute");
+    return has_attribute(prop, known_attribute::no_exception);
 }
 
 bool is_exclusive_to(TypeDef const &type) {
-    return get_category(type) == category::interface_type && has_attribute(type, "Windows.Foundation.Metadata"sv, "ExclusiveToAttribute"sv);
+    return has_attribute(type, known_attribute::exclusive_to) && get_category(type) == category::interface_type;
 }
 
 bool is_flags_enum(TypeDef const &type) {
-    return get_category(type) == category::enum_type && has_attribute(type, "System"sv, "FlagsAttribute"sv);
+    return has_attribute(type, known_attribute::flags) && get_category(type) == category::enum_type;
 }
 
 bool is_api_contract_type(TypeDef const &type) {
-    return get_category(type) == category::struct_type && has_attribute(type, "Windows.Foundation.Metadata"sv, "ApiContractAttribute"sv);
+    return has_attribute(type, known_attribute::api_contract) && get_category(type) == category::struct_type;
 }
 
 bool is_attribute_type(TypeDef const &type) {
@@ -102,29 +108,12 @@ auto get_delegate_invoke(TypeDef const &type) {
 }
 
 auto get_guid(TypeDef const &type) {
-    auto attribute = get_attribute(type, "Windows.Foundation.Metadata", "GuidAttribute");
-    if (!attribute) {
+    auto &&record = attributes(type);
+    if (!record.flags.test(static_cast<size_t>(known_attribute::guid))) {
         throw_invalid("'Windows.Foundation.Metadata.GuidAttribute' attribute for type '", type.TypeNamespace(), ".", type.TypeName(), "' not found");
     }
 
-    using std::get;
-    auto args = attribute.Value().FixedArgs();
-    auto get_arg = [&](decltype(args)::size_type index) { return get<ElemSig>(args[index].value).value; };
-
-    winrt::guid guid{};
-    guid.Data1 = get<uint32_t>(get_arg(0));
-    guid.Data2 = get<uint16_t>(get_arg(1));
-    guid.Data3 = get<uint16_t>(get_arg(2));
-    guid.Data4[0] = get<uint8_t>(get_arg(3));
-    guid.Data4[1] = get<uint8_t>(get_arg(4));
-    guid.Data4[2] = get<uint8_t>(get_arg(5));
-    guid.Data4[3] = get<uint8_t>(get_arg(6));
-    guid.Data4[4] = get<uint8_t>(get_arg(7));
-    guid.Data4[5] = get<uint8_t>(get_arg(8));
-    guid.Data4[6] = get<uint8_t>(get_arg(9));
-    guid.Data4[7] = get<uint8_t>(get_arg(10));
-
-    return guid;
+    return record.guid;
 }
 
 
@@ -181,15 +170,129 @@ using type_semantics = std::variant<
     generic_type_index,
     generic_type_param>;
 
+struct generic_instantiation;
+
+/// A generic type with its arguments. Instantiations are hash-consed, two equal ones share the
+/// same `instantiation` and can be told apart by comparing it.
 struct generic_type_instance {
     type_definition generic_type;
-    std::vector<type_semantics> generic_args{};
+    generic_instantiation const *instantiation = nullptr;
+
+    std::vector<type_semantics> const &generic_args() const;
+};
+
+/// The one copy of an instantiation, see instantiation_table
+struct generic_instantiation {
+    type_definition generic_type;
+    std::vector<type_semantics> generic_args;
+
+    // refers to a generic_type_index somewhere, so what it stands for depends on the arguments in scope
+    bool open = false;
+
+    std::string key;
+};
+
+inline std::vector<type_semantics> const &generic_type_instance::generic_args() const {
+    return instantiation->generic_args;
+}
+
+/// Interns every instantiation decoded from a signature, so `IAsyncOperation<StorageFile>` exists
+/// once however many signatures mention it. Nodes live until clear().
+class instantiation_table {
+public:
+    static generic_type_instance intern(type_definition const &generic_type, std::vector<type_semantics> &&args) {
+        auto &self = instance();
+
+        // arguments are interned before the instantiation holding them, so a key only has to go one level deep
+        thread_local std::string key;
+        key.clear();
+        append_row(generic_type, key);
+        bool open = false;
+        for (auto &&arg : args) {
+            key.push_back(static_cast<char>(arg.index()));
+            call(
+                arg,
+                [&](fundamental_type const &type) { key.push_back(static_cast<char>(type)); },
+                [&](type_definition const &type) { append_row(type, key); },
+                [&](generic_type_instance const &type) {
+                    key.append(reinterpret_cast<char const *>(&type.instantiation), sizeof(type.instantiation));
+                    open |= type.instantiation->open;
+                },
+                [&](generic_type_index const &var) {
+                    key.append(reinterpret_cast<char const *>(&var.index), sizeof(var.index));
+                    open = true;
+                },
+                [&](generic_type_param const &param) { append_row(param, key); },
+                [](auto) {});
+        }
+
+        {
+            std::shared_lock lock{ self._lock };
+            auto it = self._nodes.find(key);
+            if (it != self._nodes.end())
+                return { generic_type, it->second.get() };
+        }
+
+        auto node = std::make_unique<generic_instantiation>();
+        node->generic_type = generic_type;
+        node->generic_args = std::move(args);
+        node->open = open;
+        node->key = key;
+
+        // if another thread got there first its node wins, and this one is dropped
+        std::unique_lock lock{ self._lock };
+        auto it = self._nodes.emplace(node->key, std::move(node)).first;
+        return { generic_type, it->second.get() };
+    }
+
+    /// Drops every node, anything still holding an instantiation is invalid afterwards
+    static void clear() {
+        std::unique_lock lock{ instance()._lock };
+        instance()._nodes.clear();
+    }
+
+    static size_t size() {
+        std::shared_lock lock{ instance()._lock };
+        return instance()._nodes.size();
+    }
+
+private:
+    static instantiation_table &instance() {
+        static instantiation_table table;
+        return table;
+    }
+
+    template <typename Row>
+    static void append_row(Row const &row, std::string &key) {
+        auto db = &row.get_database();
+        auto index = row.index();
+        key.append(reinterpret_cast<char const *>(&db), sizeof(db));
+        key.append(reinterpret_cast<char const *>(&index), sizeof(index));
+    }
+
+    std::shared_mutex _lock;
+
+    // keyed by a view of the node's own key, so a lookup doesn't have to allocate one
+    std::unordered_map<std::string_view, std::unique_ptr<generic_instantiation>> _nodes;
 };
 
+/// The generic arguments in scope while a name is projected, innermost instantiation last.
+///
+/// Frames only point at arguments, an instantiation's are borrowed from the generic_type_instance
+/// for as long as its guard lives, and a type's own parameters are materialised once per type and
+/// kept. Lookups hand back references, so nothing is copied or allocated once a type has been seen.
 struct generic_args {
-    std::vector<std::vector<type_semantics>> _stack;
+    struct frame {
+        type_semantics const *args;
+        size_t size;
+    };
+
+    std::vector<frame> _stack;
     size_t _scope = 0;
 
+    // the parameters of every generic type or method pushed so far, by their first GenericParam row
+    std::map<std::pair<database const *, uint32_t>, std::vector<type_semantics>> _params;
+
     struct args_guard {
         explicit args_guard(generic_args *owner = nullptr)
             : _owner(owner) {
@@ -236,30 +339,38 @@ struct generic_args {
             return args_guard{ nullptr };
         }
 
-        _stack.emplace_back(begin(range), end(range));
+        auto &params = _params[{ &range.first.get_database(), range.first.index() }];
+        if (params.empty())
+            params = std::vector<type_semantics>(begin(range), end(range));
+
+        _stack.push_back({ params.data(), params.size() });
         return args_guard{ this };
     }
 
+    /// Borrows the arguments of `type`, from its interned instantiation
     [[nodiscard]] auto push(generic_type_instance const &type) {
-        XLANG_ASSERT(!type.generic_args.empty());
-        _stack.push_back(type.generic_args);
+        auto &args = type.generic_args();
+        XLANG_ASSERT(!args.empty());
+        _stack.push_back({ args.data(), args.size() });
         return args_guard{ this };
     }
 
-    auto get(uint32_t index) {
+    /// The argument `index` resolves to, following indexes into enclosing frames, and a guard that
+    /// keeps the lookup scope on the frame it was found in
+    std::pair<type_semantics const &, scope_guard> get(uint32_t index) {
         size_t scope = _scope > 0 ? _scope - 1 : _stack.size();
         for (size_t i = scope; i > 0; --i) {
-            auto &&args = &_stack[i - 1];
-            if (index >= args->size()) {
+            auto &args = _stack[i - 1];
+            if (index >= args.size) {
                 throw_invalid("Generic index out of range");
             }
 
-            auto &semantics = (*args)[index];
+            auto &semantics = args.args[index];
             if (auto gti = std::get_if<generic_type_index>(&semantics)) {
                 index = gti->index;
                 continue;
             }
-            return std::pair{ semantics, scope_guard(*this, i) };
+            return { semantics, scope_guard(*this, i) };
         }
         throw_invalid("No generic arguments");
     }
@@ -269,7 +380,64 @@ struct generic_args {
     }
 };
 
+/// What each TypeDefOrRef coded index resolves to, so a TypeRef costs its find_required and name
+/// checks once rather than every time a signature mentions it. Entries live until clear().
+class type_semantics_cache {
+public:
+    template <typename F>
+    static type_semantics const &get(coded_index<TypeDefOrRef> const &type, F &&resolve) {
+        auto &self = instance();
+        key k{ &type.get_database(), static_cast<uint32_t>(type.type()), type.index() };
+
+        {
+            std::shared_lock lock{ self._lock };
+            auto it = self._types.find(k);
+            if (it != self._types.end())
+                return it->second;
+        }
+
+        // resolved outside the lock, it may decode an instantiation and come back here
+        auto semantics = resolve();
+
+        std::unique_lock lock{ self._lock };
+        return self._types.emplace(k, std::move(semantics)).first->second;
+    }
+
+    static void clear() {
+        std::unique_lock lock{ instance()._lock };
+        instance()._types.clear();
+    }
+
+private:
+    struct key {
+        database const *db;
+        uint32_t type;
+        uint32_t index;
+
+        bool operator==(key const &other) const {
+            return db == other.db && type == other.type && index == other.index;
+        }
+    };
+
+    struct key_hash {
+        size_t operator()(key const &k) const {
+            return std::hash<database const *>{}(k.db) ^ ((static_cast<size_t>(k.index) << 2 | k.type) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    static type_semantics_cache &instance() {
+        static type_semantics_cache cache;
+        return cache;
+    }
+
+    std::shared_mutex _lock;
+
+    // node based, so a reference handed out stays good as the map grows
+    std::unordered_map<key, type_semantics, key_hash> _types;
+};
+
 type_semantics get_type_semantics(TypeSig const &signature);
+type_semantics get_type_semantics(coded_index<TypeDefOrRef> const &type);
 
 type_semantics get_type_semantics(GenericTypeInstSig const &type) {
     auto generic_type_helper = [&type]() {
@@ -277,22 +445,21 @@ type_semantics get_type_semantics(GenericTypeInstSig const &type) {
         case TypeDefOrRef::TypeDef:
             return type.GenericType().TypeDef();
         case TypeDefOrRef::TypeRef:
-            return find_required(type.GenericType().TypeRef());
+            return std::get<type_definition>(get_type_semantics(type.GenericType()));
         }
 
         throw_invalid("invalid TypeDefOrRef value for GenericTypeInstSig.GenericType");
     };
 
-    auto gti = generic_type_instance{ generic_type_helper() };
-
+    std::vector<type_semantics> args;
     for (auto &&arg : type.GenericArgs()) {
-        gti.generic_args.push_back(get_type_semantics(arg));
+        args.push_back(get_type_semantics(arg));
     }
 
-    return gti;
+    return instantiation_table::intern(generic_type_helper(), std::move(args));
 }
 
-type_semantics get_type_semantics(coded_index<TypeDefOrRef> const &type) {
+type_semantics resolve_type_semantics(coded_index<TypeDefOrRef> const &type) {
     switch (type.type()) {
     case TypeDefOrRef::TypeDef:
         return type.TypeDef();
@@ -323,6 +490,10 @@ type_semantics get_type_semantics(coded_index<TypeDefOrRef> const &type) {
     throw_invalid("TypeDefOrRef not supported");
 }
 
+type_semantics get_type_semantics(coded_index<TypeDefOrRef> const &type) {
+    return type_semantics_cache::get(type, [&] { return resolve_type_semantics(type); });
+}
+
 namespace impl {
     template <class... Ts>
     struct overloaded : Ts... {
@@ -514,7 +685,7 @@ inline coded_index<TypeDefOrRef> get_default_interface(TypeDef const &type) {
     auto impls = type.InterfaceImpl();
 
     for (auto &&impl : impls) {
-        if (has_attribute(impl, "Windows.Foundation.Metadata", "DefaultAttribute")) {
+        if (has_attribute(impl, known_attribute::default_interface)) {
             return impl.Interface();
         }
     }
@@ -526,173 +697,9 @@ inline coded_index<TypeDefOrRef> get_default_interface(TypeDef const &type) {
     return {};
 }
 
-struct mapped_type {
-    std::string_view abi_name;
-    std::string_view mapped_namespace;
-    std::string_view mapped_name;
-    bool requires_marshaling;
-    bool has_custom_members_output;
-};
-
-inline const std::initializer_list<mapped_type> get_mapped_types_in_namespace(std::string_view typeNamespace) {
-    static const struct
-    {
-        std::string_view name_space;
-        std::initializer_list<mapped_type> types;
-    } mapped_types[] = {
-        // Make sure to keep this table consistent with the registrations in WinRT.Runtime/Projections.cs
-        // NOTE: Must keep namespaces sorted (outer) and abi type names sorted (inner)
-        { "Microsoft.UI.Xaml",
-            {
-                { "CornerRadius", "Microsoft.UI.Xaml", "CornerRadius" },
-                { "CornerRadiusHelper" },
-                { "Duration", "Microsoft.UI.Xaml", "Duration" },
-                { "DurationHelper" },
-                { "DurationType", "Microsoft.UI.Xaml", "DurationType" },
-                { "GridLength", "Microsoft.UI.Xaml", "GridLength" },
-                { "GridLengthHelper" },
-                { "GridUnitType", "Microsoft.UI.Xaml", "GridUnitType" },
-                { "ICornerRadiusHelper" },
-                { "ICornerRadiusHelperStatics" },
-                { "IDurationHelper" },
-                { "IDurationHelperStatics" },
-                { "IGridLengthHelper" },
-                { "IGridLengthHelperStatics" },
-                { "IThicknessHelper" },
-                { "IThicknessHelperStatics" },
-                { "Thickness", "Microsoft.UI.Xaml", "Thickness" },
-                { "ThicknessHelper" },
-                { "IXamlServiceProvider", "System", "IServiceProvider" },
-            } },
-        { "Microsoft.UI.Xaml.Controls.Primitives",
-            {
-                { "GeneratorPosition", "Microsoft.UI.Xaml.Controls.Primitives", "GeneratorPosition" },
-                { "GeneratorPositionHelper" },
-                { "IGeneratorPositionHelper" },
-                { "IGeneratorPositionHelperStatics" },
-            } },
-        { "Microsoft.UI.Xaml.Data",
-            {
-                { "DataErrorsChangedEventArgs", "System.ComponentModel", "DataErrorsChangedEventArgs" },
-                { "INotifyDataErrorInfo", "System.ComponentModel", "INotifyDataErrorInfo", true, true },
-                { "INotifyPropertyChanged", "System.ComponentModel", "INotifyPropertyChanged" },
-                { "PropertyChangedEventArgs", "System.ComponentModel", "PropertyChangedEventArgs" },
-                { "PropertyChangedEventHandler", "System.ComponentModel", "PropertyChangedEventHandler" },
-            } },
-        { "Microsoft.UI.Xaml.Input",
-            { { "ICommand", "System.Windows.Input", "ICommand", true } } },
-        { "Microsoft.UI.Xaml.Interop",
-            {
-                { "IBindableIterable", "System.Collections", "IEnumerable", true },
-                { "IBindableVector", "System.Collections", "IList", true },
-                { "INotifyCollectionChanged", "System.Collections.Specialized", "INotifyCollectionChanged", true },
-                { "NotifyCollectionChangedAction", "System.Collections.Specialized", "NotifyCollectionChangedAction" },
-                { "NotifyCollectionChangedEventArgs", "System.Collections.Specialized", "NotifyCollectionChangedEventArgs", true },
-                { "NotifyCollectionChangedEventHandler", "System.Collections.Specialized", "NotifyCollectionChangedEventHandler", true },
-            } },
-        { "Microsoft.UI.Xaml.Media",
-            {
-                { "IMatrixHelper" },
-                { "IMatrixHelperStatics" },
-                { "Matrix", "Microsoft.UI.Xaml.Media", "Matrix" },
-                { "MatrixHelper" },
-            } },
-        { "Microsoft.UI.Xaml.Media.Animation",
-            { { "IKeyTimeHelper" },
-                { "IKeyTimeHelperStatics" },
-                { "IRepeatBehaviorHelper" },
-                { "IRepeatBehaviorHelperStatics" },
-                { "KeyTime", "Microsoft.UI.Xaml.Media.Animation", "KeyTime" },
-                { "KeyTimeHelper" },
-                { "RepeatBehavior", "Microsoft.UI.Xaml.Media.Animation", "RepeatBehavior" },
-                { "RepeatBehaviorHelper" },
-                { "RepeatBehaviorType", "Microsoft.UI.Xaml.Media.Animation", "RepeatBehaviorType" } } },
-        { "Microsoft.UI.Xaml.Media.Media3D",
-            {
-                { "IMatrix3DHelper" },
-                { "IMatrix3DHelperStatics" },
-                { "Matrix3D", "Microsoft.UI.Xaml.Media.Media3D", "Matrix3D" },
-                { "Matrix3DHelper" },
-            } },
-        { "Windows.Foundation",
-            { { "DateTime", "System", "DateTimeOffset", true },
-                { "EventHandler`1", "System", "EventHandler", false },
-                { "EventRegistrationToken", "WinRT", "EventRegistrationToken", false },
-                { "HResult", "System", "Exception", true },
-                { "IClosable", "System", "IDisposable", true, true },
-                { "IPropertyValue", "Windows.Foundation", "IPropertyValue", true },
-                { "IReferenceArray`1", "Windows.Foundation", "IReferenceArray", true },
-                { "IReference`1", "System", "Nullable", true },
-                { "Point", "Windows.Foundation", "Point" },
-                { "Rect", "Windows.Foundation", "Rect" },
-                { "Size", "Windows.Foundation", "Size" },
-                { "TimeSpan", "System", "TimeSpan", true },
-                { "Uri", "System", "Uri", true } } },
-        { "Windows.Foundation.Collections",
-            {
-                { "IIterable`1", "System.Collections.Generic", "IEnumerable`1", true, true },
-                { "IIterator`1", "System.Collections.Generic", "IEnumerator`1", true, true },
-                { "IKeyValuePair`2", "System.Collections.Generic", "KeyValuePair`2", true },
-                { "IMapView`2", "System.Collections.Generic", "IReadOnlyDictionary`2", true, true },
-                { "IMap`2", "System.Collections.Generic", "IDictionary`2", true, true },
-                { "IVectorView`1", "System.Collections.Generic", "IReadOnlyList`1", true, true },
-                { "IVector`1", "System.Collections.Generic", "IList`1", true, true },
-            } },
-        { "Windows.Foundation.Metadata",
-            {
-                { "AttributeTargets", "System", "AttributeTargets" },
-                { "AttributeUsageAttribute", "System", "AttributeUsageAttribute" },
-            } },
-        { "Windows.Foundation.Numerics",
-            {
-                { "Matrix3x2", "System.Numerics", "Matrix3x2" },
-                { "Matrix4x4", "System.Numerics", "Matrix4x4" },
-                { "Plane", "System.Numerics", "Plane" },
-                { "Quaternion", "System.Numerics", "Quaternion" },
-                { "Vector2", "System.Numerics", "Vector2" },
-                { "Vector3", "System.Numerics", "Vector3" },
-                { "Vector4", "System.Numerics", "Vector4" },
-            } },
-        { "Windows.UI",
-            {
-                { "Color", "Windows.UI", "Color" },
-                { "ColorHelper" },
-                { "IColorHelper" },
-                { "IColorHelperStatics" },
-                { "IColorHelperStatics2" },
-            } },
-        // Temporary, until WinUI provides TypeName
-        { "Windows.UI.Xaml.Interop",
-            { { "TypeKind", "Windows.UI.Xaml.Interop", "TypeKind", true },
-                { "TypeName", "System", "Type", true } } },
-    };
-
-    auto nsItr = std::lower_bound(std::begin(mapped_types), std::end(mapped_types), typeNamespace, [](auto &&v, std::string_view ns) {
-        return v.name_space < ns;
-    });
-
-    if ((nsItr == std::end(mapped_types)) || (nsItr->name_space != typeNamespace)) {
-        return {};
-    }
-
-    return nsItr->types;
-}
-
 inline const mapped_type *get_mapped_type(std::string_view typeNamespace, std::string_view typeName) {
-    auto mapped_types = get_mapped_types_in_namespace(typeNamespace);
-
-    if (mapped_types.size() == 0) {
-        return nullptr;
-    }
-
-    auto nameItr = std::lower_bound(mapped_types.begin(), mapped_types.end(), typeName, [](auto &&v, std::string_view name) {
-        return v.abi_name < name;
-    });
-    if ((nameItr == mapped_types.end()) || (nameItr->abi_name != typeName)) {
-        return nullptr;
-    }
-
-    return &*nameItr;
+    auto mapping = type_map::current().find(typeNamespace, typeName);
+    return mapping ? &mapping->type : nullptr;
 }
 
 enum class typedef_name_type {
@@ -788,7 +795,7 @@ std::string get_mapped_element_type(ElementType elementType) {
     }
 }
 
-bool are_equal(const winmd::reader::MethodDef &iface_method, winmd::reader::MethodDef &method) {
+bool are_equal(MethodDef const &iface_method, MethodDef const &method) {
     if (iface_method.Name() != method.Name()) {
         return false;
     };
@@ -799,22 +806,16 @@ bool are_equal(const winmd::reader::MethodDef &iface_method, winmd::reader::Meth
         return false;
     };
 
-    if (ret_type.Type().Type().index() != iface_ret_type.Type().Type().index()) {
+    if (ret_type && ret_type.Type().Type().index() != iface_ret_type.Type().Type().index()) {
         return false;
     };
 
-    if (distance(method.ParamList()) != distance(iface_method.ParamList()))
+    auto params = method.ParamList();
+    auto iface_params = iface_method.ParamList();
+    if (distance(params) != distance(iface_params))
         return false;
 
-    std::vector<Param> lhs(distance(method.ParamList()));
-    std::copy(begin(method.ParamList()), end(method.ParamList()), lhs.begin());
-    std::vector<Param> rhs(distance(iface_method.ParamList()));
-    std::copy(begin(iface_method.ParamList()), end(iface_method.ParamList()), rhs.begin());
-
-    for (size_t i = 0; i < distance(method.ParamList()); i++) {
-        auto it1 = lhs.at(i);
-        auto it2 = rhs.at(i);
-
+    for (auto it1 = begin(params), it2 = begin(iface_params); it1 != end(params); ++it1, ++it2) {
         if (it1.Name() != it2.Name())
             return false;
 
@@ -824,56 +825,3 @@ bool are_equal(const winmd::reader::MethodDef &iface_method, winmd::reader::Meth
 
     return true;
 }
-
-const MethodDef &get_interface_method(TypeDef &parent_type, MethodDef &method, bool &is_static) {
-    auto get_system_type = [&](auto &&signature) -> TypeDef {
-        for (auto &&arg : signature.FixedArgs()) {
-            if (auto type_param = std::get_if<ElemSig::SystemType>(&std::get<ElemSig>(arg.value).value)) {
-                return parent_type.get_cache().find_required(type_param->name);
-            }
-        }
-
-        return {};
-    };
-
-    std::vector<TypeDef> ifaces(distance(parent_type.InterfaceImpl()));
-
-    for (auto &&iface : parent_type.InterfaceImpl()) {
-        auto iface_type = get_type_semantics(iface.Interface());
-        auto iface_type_definition = std::get_if<type_definition>(&iface_type);
-        if (iface_type_definition != nullptr)
-            ifaces.push_back(parent_type.get_cache().find_required((*iface_type_definition).TypeNamespace(), (*iface_type_definition).TypeName()));
-    }
-
-    for (auto &&iface_type_definition : ifaces) {
-        if (!iface_type_definition || distance(iface_type_definition.MethodList()) == 0)
-            continue;
-
-        for (auto &&iface_method : iface_type_definition.MethodList()) {
-            if (!are_equal(iface_method, method))
-                continue;
-
-            return iface_method;
-        }
-    }
-
-    for (auto &&attribute : parent_type.CustomAttribute()) {
-        auto attribute_name = attribute.TypeNamespaceAndName();
-
-        if (attribute_name.first != "Windows.Foundation.Metadata") {
-            continue;
-        }
-        if (attribute_name.second == "StaticAttribute") {
-            auto iface_type_definition = get_system_type(attribute.Value());
-            for (auto &&iface_method : iface_type_definition.MethodList()) {
-                if (!are_equal(iface_method, method))
-                    continue;
-
-                is_static = true;
-                return iface_method;
-            }
-        }
-    }
-
-    return {};
-}
\ No newline at end of file
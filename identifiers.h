@@ -0,0 +1,233 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <winmd_reader.h>
+#include "metadata_index.h"
+#include "snapshot.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TSWINRT_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+using namespace winmd::reader;
+
+/// Identifiers that can't be used as member or parameter names in TypeScript
+inline bool is_banned_identifier(std::string_view const& name) {
+    return name == "function" || name == "arguments" || name == "package";
+}
+
+#ifdef TSWINRT_SSE2
+inline uint32_t lowest_set_bit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+/// Lowercases the leading run of `name[0, size)` that ends at the first '_' or lowercase letter, and
+/// returns its length.
+///
+/// Reads (but never changes) up to 15 bytes past `size`, so the buffer must be padded.
+inline size_t fold_leading_upper_run(char* name, size_t size) {
+    size_t i = 0;
+#ifdef TSWINRT_SSE2
+    auto const underscore = _mm_set1_epi8('_');
+    auto const before_a = _mm_set1_epi8('a' - 1);
+    auto const after_z = _mm_set1_epi8('z' + 1);
+    auto const before_upper_a = _mm_set1_epi8('A' - 1);
+    auto const after_upper_z = _mm_set1_epi8('Z' + 1);
+    auto const case_bit = _mm_set1_epi8(0x20);
+    auto const lanes = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    for (; i < size; i += 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(name + i));
+        auto lower = _mm_and_si128(_mm_cmpgt_epi8(chunk, before_a), _mm_cmplt_epi8(chunk, after_z));
+        uint32_t stop = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, underscore), lower));
+
+        // anything past the end of the name stops the run as well
+        if (size - i < 16)
+            stop |= ~0u << (size - i);
+
+        uint32_t run = stop != 0 ? lowest_set_bit(stop) : 16;
+        auto in_run = _mm_cmplt_epi8(lanes, _mm_set1_epi8(static_cast<char>(run)));
+        auto upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, before_upper_a), _mm_cmplt_epi8(chunk, after_upper_z));
+        chunk = _mm_or_si128(chunk, _mm_and_si128(_mm_and_si128(upper, in_run), case_bit));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(name + i), chunk);
+
+        if (run != 16)
+            return i + run;
+    }
+
+    return size;
+#else
+    for (; i < size && name[i] != '_' && !(name[i] >= 'a' && name[i] <= 'z'); i++) {
+        if (name[i] >= 'A' && name[i] <= 'Z')
+            name[i] += 'a' - 'A';
+    }
+
+    return i;
+#endif
+}
+
+/// Appends the TypeScript name of a member or parameter called `name` to `out`: a leading
+/// uppercase run is lowercased (`URI` -> `uri`, `IPAddress` -> `ipaddress`, `Name` -> `name`) and
+/// names TypeScript won't accept are prefixed with `__`
+inline void normalise_member_name(std::string_view const& name, std::string& out) {
+    if (!name.empty() && name[0] >= 'A' && name[0] <= 'Z') {
+        auto offset = out.size();
+        out.append(name);
+        out.append(16, '\0'); // padding for the vectorised fold
+        fold_leading_upper_run(out.data() + offset, name.size());
+        out.resize(offset + name.size());
+        return;
+    }
+
+    if (is_banned_identifier(name))
+        out += "__";
+
+    out += name;
+}
+
+/// The normalised names of every field, parameter, property, event and method in a database,
+/// computed in one pass and interned into a single arena
+class identifier_table {
+public:
+    explicit identifier_table(database const& db) {
+        // worst case every name is stored once, with a prefix, so the arena never moves and views
+        // into it stay valid while we dedupe
+        size_t capacity = 16;
+        auto measure = [&](auto const& table) {
+            for (auto&& row : table) {
+                capacity += row.Name().size() + 2;
+            }
+        };
+
+        measure(db.Field);
+        measure(db.Param);
+        measure(db.Property);
+        measure(db.Event);
+        measure(db.MethodDef);
+        _arena = std::make_unique<char[]>(capacity);
+
+        _fields = intern_all(db.Field);
+        _params = intern_all(db.Param);
+        _properties = intern_all(db.Property);
+        _events = intern_all(db.Event);
+        _methods = intern_all(db.MethodDef);
+        _interned.clear();
+        _text = _arena.get();
+    }
+
+    /// Reads the table back from a snapshot, the names stay in the mapping
+    identifier_table(database const& db, snapshot_reader& in) : _snapshot(in.file()) {
+        auto [text, size] = in.read_array<char>();
+        _text = text;
+        _size = size;
+
+        auto load = [&](auto const& table, std::vector<span>& spans) {
+            auto [first, count] = in.read_array<span>();
+            if (count != table.size())
+                throw std::runtime_error("snapshot doesn't match the database");
+
+            for (size_t i = 0; i < count; i++) {
+                if (first[i].offset + first[i].length > _size)
+                    throw std::runtime_error("snapshot doesn't match the database");
+            }
+
+            spans.assign(first, first + count);
+        };
+
+        load(db.Field, _fields);
+        load(db.Param, _params);
+        load(db.Property, _properties);
+        load(db.Event, _events);
+        load(db.MethodDef, _methods);
+    }
+
+    void save(snapshot_writer& out) const {
+        out.write_array(_text, _size);
+        out.write_array(_fields);
+        out.write_array(_params);
+        out.write_array(_properties);
+        out.write_array(_events);
+        out.write_array(_methods);
+    }
+
+    std::string_view operator[](Field const& row) const { return view(_fields[row.index()]); }
+    std::string_view operator[](Param const& row) const { return view(_params[row.index()]); }
+    std::string_view operator[](Property const& row) const { return view(_properties[row.index()]); }
+    std::string_view operator[](Event const& row) const { return view(_events[row.index()]); }
+    std::string_view operator[](MethodDef const& row) const { return view(_methods[row.index()]); }
+
+private:
+    struct span {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    template <typename Table>
+    std::vector<span> intern_all(Table const& table) {
+        std::vector<span> spans;
+        spans.reserve(table.size());
+        for (auto&& row : table) {
+            spans.push_back(intern(row.Name()));
+        }
+
+        return spans;
+    }
+
+    span intern(std::string_view const& name) {
+        auto first = _arena.get() + _size;
+        size_t length = name.size();
+
+        if (!name.empty() && name[0] >= 'A' && name[0] <= 'Z') {
+            // the fold reads past the name, into the arena's tail or what's left of its padding
+            std::copy(name.begin(), name.end(), first);
+            fold_leading_upper_run(first, length);
+        }
+        else {
+            if (is_banned_identifier(name)) {
+                std::copy_n("__", 2, first);
+                length += 2;
+            }
+
+            std::copy(name.begin(), name.end(), first + (length - name.size()));
+        }
+
+        // the same name shows up all over a database, keep the first copy and give the space back
+        auto [it, inserted] = _interned.emplace(std::string_view{ first, length }, span{ static_cast<uint32_t>(_size), static_cast<uint32_t>(length) });
+        if (inserted)
+            _size += length;
+
+        return it->second;
+    }
+
+    std::string_view view(span const& s) const {
+        return { _text + s.offset, s.length };
+    }
+
+    std::unique_ptr<char[]> _arena;
+    std::shared_ptr<mapped_file const> _snapshot;
+    char const* _text = nullptr; // the arena, or the names in the snapshot it was read from
+    size_t _size = 0;
+    std::unordered_map<std::string_view, span> _interned;
+    std::vector<span> _fields;
+    std::vector<span> _params;
+    std::vector<span> _properties;
+    std::vector<span> _events;
+    std::vector<span> _methods;
+};
+
+template <typename T>
+std::string_view member_name(T const& row) {
+    return database_index<identifier_table>::get(row.get_database())[row];
+}
@@ -0,0 +1,217 @@
+#pragma once
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <winmd_reader.h>
+#include "platform.h"
+#include "helpers.h"
+#include "sha1.h"
+
+using namespace winmd::reader;
+
+/// Appends the lowercase, braced form of `guid` to `out`: {faa585ea-6214-4217-afda-7f46de5869b3}
+inline void append_guid(winrt::guid const& guid, std::string& out) {
+    char buffer[40];
+    snprintf(buffer, sizeof buffer, "{%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x}",
+        guid.Data1, guid.Data2, guid.Data3,
+        guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3],
+        guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
+    out += buffer;
+}
+
+/// Appends the Windows Runtime type signature of `type` to `out`, the string the IID of a
+/// parameterized interface is derived from
+inline void append_type_signature(type_semantics const& type, std::string& out) {
+    call(
+        type,
+        [&](fundamental_type const& type) {
+            switch (type) {
+            case fundamental_type::Boolean: out += "b1"; break;
+            case fundamental_type::Char: out += "c2"; break;
+            case fundamental_type::Int8: out += "i1"; break;
+            case fundamental_type::UInt8: out += "u1"; break;
+            case fundamental_type::Int16: out += "i2"; break;
+            case fundamental_type::UInt16: out += "u2"; break;
+            case fundamental_type::Int32: out += "i4"; break;
+            case fundamental_type::UInt32: out += "u4"; break;
+            case fundamental_type::Int64: out += "i8"; break;
+            case fundamental_type::UInt64: out += "u8"; break;
+            case fundamental_type::Float: out += "f4"; break;
+            case fundamental_type::Double: out += "f8"; break;
+            case fundamental_type::String: out += "string"; break;
+            }
+        },
+        [&](object_type) { out += "cinterface(IInspectable)"; },
+        [&](guid_type) { out += "g16"; },
+        [&](type_definition const& type) {
+            auto full_name = [&]() {
+                out += type.TypeNamespace();
+                out += ".";
+                out += type.TypeName();
+            };
+
+            switch (get_category(type)) {
+            case category::interface_type:
+                append_guid(get_guid(type), out);
+                break;
+            case category::delegate_type:
+                out += "delegate(";
+                append_guid(get_guid(type), out);
+                out += ")";
+                break;
+            case category::class_type:
+                out += "rc(";
+                full_name();
+                out += ";";
+                append_type_signature(get_type_semantics(get_default_interface(type)), out);
+                out += ")";
+                break;
+            case category::enum_type:
+                out += "enum(";
+                full_name();
+                out += is_flags_enum(type) ? ";u4)" : ";i4)";
+                break;
+            case category::struct_type:
+                out += "struct(";
+                full_name();
+                for (auto&& field : type.FieldList()) {
+                    out += ";";
+                    append_type_signature(get_type_semantics(field.Signature().Type()), out);
+                }
+                out += ")";
+                break;
+            default:
+                throw_invalid("'", type.TypeNamespace(), ".", type.TypeName(), "' has no type signature");
+            }
+        },
+        [&](generic_type_instance const& type) {
+            out += "pinterface(";
+            append_guid(get_guid(type.generic_type), out);
+            for (auto&& arg : type.generic_args()) {
+                out += ";";
+                append_type_signature(arg, out);
+            }
+            out += ")";
+        },
+        [](auto) {
+            throw_invalid("only closed types have a type signature");
+        });
+}
+
+/// The IIDs of interfaces and delegates.
+///
+/// Plain ones come straight from the GuidAttribute decoded into the attribute table. Those of
+/// parameterized instantiations are derived from their type signature as a version 5 UUID, and
+/// remembered for each instantiation.
+class iid_cache {
+public:
+    static winrt::guid get(type_semantics const& type) {
+        if (auto definition = std::get_if<type_definition>(&type)) {
+            // runtime classes are passed around as their default interface
+            if (get_category(*definition) == category::class_type)
+                return get(get_type_semantics(get_default_interface(*definition)));
+
+            return get_guid(*definition);
+        }
+
+        prepare({ type });
+
+        std::shared_lock lock{ instance()._lock };
+        return instance()._iids.at(key(type));
+    }
+
+    /// Computes the IIDs of every parameterized instantiation in `types` that isn't known yet,
+    /// hashing their signatures as one batch
+    static void prepare(std::vector<type_semantics> const& types) {
+        auto& self = instance();
+        std::vector<std::string> keys;
+        std::vector<std::string> messages;
+
+        {
+            std::shared_lock lock{ self._lock };
+            for (auto&& type : types) {
+                if (!std::holds_alternative<generic_type_instance>(type))
+                    continue;
+
+                auto k = key(type);
+                if (self._iids.find(k) != self._iids.end())
+                    continue;
+
+                std::string message(reinterpret_cast<char const*>(pinterface_namespace), sizeof pinterface_namespace);
+                append_type_signature(type, message);
+                keys.push_back(std::move(k));
+                messages.push_back(std::move(message));
+            }
+        }
+
+        if (keys.empty())
+            return;
+
+        auto digests = sha1_batch(std::vector<std::string_view>(messages.begin(), messages.end()));
+
+        std::unique_lock lock{ self._lock };
+        for (size_t i = 0; i < keys.size(); i++) {
+            self._iids.emplace(std::move(keys[i]), to_guid(digests[i]));
+        }
+    }
+
+    static void clear() {
+        std::unique_lock lock{ instance()._lock };
+        instance()._iids.clear();
+    }
+
+private:
+    // 11f47ad5-7b73-42c0-abae-878b1e16adee, in network byte order
+    static constexpr uint8_t pinterface_namespace[16] = { 0x11, 0xf4, 0x7a, 0xd5, 0x7b, 0x73, 0x42, 0xc0, 0xab, 0xae, 0x87, 0x8b, 0x1e, 0x16, 0xad, 0xee };
+
+    static iid_cache& instance() {
+        static iid_cache cache;
+        return cache;
+    }
+
+    // identifies an instantiation by the rows it's made of, rather than by its much longer signature
+    static std::string key(type_semantics const& type) {
+        std::string k;
+        append_key(type, k);
+        return k;
+    }
+
+    static void append_key(type_semantics const& type, std::string& k) {
+        k.push_back(static_cast<char>(type.index()));
+        call(
+            type,
+            [&](fundamental_type const& type) { k.push_back(static_cast<char>(type)); },
+            [&](type_definition const& type) {
+                auto db = &type.get_database();
+                auto index = type.index();
+                k.append(reinterpret_cast<char const*>(&db), sizeof db);
+                k.append(reinterpret_cast<char const*>(&index), sizeof index);
+            },
+            [&](generic_type_instance const& type) {
+                // interned, so the node stands for the whole instantiation
+                k.append(reinterpret_cast<char const*>(&type.instantiation), sizeof(type.instantiation));
+            },
+            [](auto) {});
+    }
+
+    static winrt::guid to_guid(sha1_digest digest) {
+        // stamp it as a name based, SHA-1 UUID
+        digest[6] = (digest[6] & 0x0f) | 0x50;
+        digest[8] = (digest[8] & 0x3f) | 0x80;
+
+        winrt::guid guid{};
+        guid.Data1 = sha1_impl::load_be32(digest.data());
+        guid.Data2 = static_cast<uint16_t>((digest[4] << 8) | digest[5]);
+        guid.Data3 = static_cast<uint16_t>((digest[6] << 8) | digest[7]);
+        std::copy(digest.begin() + 8, digest.begin() + 16, guid.Data4);
+        return guid;
+    }
+
+    std::shared_mutex _lock;
+    std::unordered_map<std::string, winrt::guid> _iids;
+};
+
+inline winrt::guid get_iid(type_semantics const& type) {
+    return iid_cache::get(type);
+}
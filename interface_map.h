@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+#include <winmd_reader.h>
+#include "helpers.h"
+#include "attributes.h"
+#include "metadata_index.h"
+#include "namespace_filter.h"
+
+using namespace winmd::reader;
+
+/// The interface method a class method is dispatched through
+struct interface_method {
+    MethodDef method;
+    bool is_static = false;
+};
+
+/// The interfaces of a class or interface, resolved once
+struct type_interfaces {
+    // the InterfaceImpls as declared, generic instantiations included
+    std::vector<type_semantics> declared;
+
+    // every non-generic interface implemented, directly or through another interface, each once,
+    // in breadth first order
+    std::vector<TypeDef> closure;
+
+    // class methods, by row, to the interface method implementing them
+    std::unordered_map<uint32_t, interface_method> methods;
+};
+
+/// The interfaces of every class and interface in a database, and the method map of every class.
+/// Types outside `filter` are never projected, their records are left empty.
+class interface_table {
+public:
+    explicit interface_table(database const& db, namespace_filter const& filter = {}) : _types(db.TypeDef.size()) {
+        // types come grouped by namespace, so the filter is asked once per run of them
+        std::string_view ns;
+        bool included = true;
+        for (auto&& type : db.TypeDef) {
+            if (!filter.empty() && type.TypeNamespace() != ns) {
+                ns = type.TypeNamespace();
+                included = filter.matches(ns);
+            }
+
+            if (!included)
+                continue;
+
+            auto category = get_category(type);
+            if (category == category::class_type || category == category::interface_type)
+                build(type, _types[type.index()]);
+        }
+    }
+
+    type_interfaces const& operator[](TypeDef const& row) const {
+        return _types[row.index()];
+    }
+
+private:
+    static void build(TypeDef const& type, type_interfaces& record) {
+        for (auto&& impl : type.InterfaceImpl()) {
+            record.declared.push_back(get_type_semantics(impl.Interface()));
+            if (auto iface = std::get_if<type_definition>(&record.declared.back()))
+                add_interface(record.closure, *iface);
+        }
+
+        for (size_t i = 0; i < record.closure.size(); i++) {
+            for (auto&& impl : record.closure[i].InterfaceImpl()) {
+                auto semantics = get_type_semantics(impl.Interface());
+                if (auto iface = std::get_if<type_definition>(&semantics))
+                    add_interface(record.closure, *iface);
+            }
+        }
+
+        if (get_category(type) != category::class_type)
+            return;
+
+        // the instance interfaces are searched before the statics ones, and in each the first
+        // method that matches wins
+        std::unordered_map<std::string_view, std::vector<interface_method>> candidates;
+        for (auto&& iface : record.closure) {
+            for (auto&& method : iface.MethodList()) {
+                candidates[method.Name()].push_back({ method, false });
+            }
+        }
+
+        for (auto&& statics : attributes(type).statics) {
+            if (statics.empty())
+                continue;
+
+            for (auto&& method : type.get_cache().find_required(statics).MethodList()) {
+                candidates[method.Name()].push_back({ method, true });
+            }
+        }
+
+        for (auto&& method : type.MethodList()) {
+            auto it = candidates.find(method.Name());
+            if (it == candidates.end())
+                continue;
+
+            for (auto&& candidate : it->second) {
+                if (are_equal(candidate.method, method)) {
+                    record.methods.emplace(method.index(), candidate);
+                    break;
+                }
+            }
+        }
+    }
+
+    static void add_interface(std::vector<TypeDef>& closure, TypeDef const& iface) {
+        if (std::find(closure.begin(), closure.end(), iface) == closure.end())
+            closure.push_back(iface);
+    }
+
+    std::vector<type_interfaces> _types;
+};
+
+inline type_interfaces const& get_interfaces(TypeDef const& type) {
+    return database_index<interface_table>::get(type.get_database())[type];
+}
+
+/// Finds the method of an interface implemented by `parent_type` that `method` is dispatched
+/// through, sets `is_static` when that's one of its statics interfaces
+inline MethodDef get_interface_method(TypeDef const& parent_type, MethodDef const& method, bool& is_static) {
+    auto&& methods = get_interfaces(parent_type).methods;
+    auto it = methods.find(method.index());
+    if (it == methods.end())
+        return {};
+
+    is_static = it->second.is_static;
+    return it->second.method;
+}
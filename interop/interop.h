@@ -5,6 +5,9 @@
 #include <winrt/base.h>
 #include <winmd_reader.h>
 #include "../helpers.h"
+#include "../interface_map.h"
+#include "../iid.h"
+#include "../metadata_index.h"
 
 using namespace winmd::reader;
 
@@ -46,25 +49,58 @@ namespace interop {
         return (*reinterpret_cast<void const* const* const*>(instance))[slot];
     }
 
-    uint32_t compute_method_slot_index(MethodDef& method) {
-        // TODO We should really add this as a member function on 'method'.  We can trivially compute
-        // it by determining the index of the method in its element context table.  We should also
-        // only scan declared methods, not all methods.
-        TypeDef& parent_type = method.Parent();
-        uint32_t slot_index(0);
-        for (auto& it : parent_type.MethodList()) {
-            if (it == method)
-                break;
-
-            ++slot_index;
+    // IUnknown has three functions, and IInspectable has an additional three functions, every
+    // Windows Runtime interface method comes after them
+    constexpr uint32_t inspectable_slot_count = 6;
+
+    /// The vtable slot of every interface method in a database, indexed by method row.
+    ///
+    /// Methods of an interface are contiguous in the MethodDef table and laid out in the vtable in
+    /// the same order, so a slot is just the distance from the first method of its interface.
+    class vtable_slot_table {
+    public:
+        static constexpr uint32_t no_slot = ~0u;
+
+        explicit vtable_slot_table(database const& db) : _slots(db.MethodDef.size(), no_slot) {
+            for (auto&& type : db.TypeDef) {
+                if (get_category(type) != category::interface_type)
+                    continue;
+
+                auto [first, last] = type.MethodList();
+                for (auto method = first; method != last; ++method) {
+                    _slots[method.index()] = method.index() - first.index() + inspectable_slot_count;
+                }
+            }
         }
 
-        // TODO Error checking?
-        return slot_index;
+        uint32_t operator[](MethodDef const& method) const {
+            return _slots[method.index()];
+        }
+
+    private:
+        std::vector<uint32_t> _slots;
+    };
+
+    /// The vtable slot of an interface method, IUnknown and IInspectable included
+    inline uint32_t vtable_slot(MethodDef const& method) {
+        auto slot = database_index<vtable_slot_table>::get(method.get_database())[method];
+        if (slot == vtable_slot_table::no_slot)
+            throw_invalid("'", method.Name(), "' is not an interface method");
+
+        return slot;
+    }
+
+    /// The function pointer of an interface method, on an instance of that interface
+    inline void const* compute_function_pointer(void const* const instance, MethodDef const& method) {
+        return compute_function_pointer(instance, vtable_slot(method));
+    }
+
+    uint32_t compute_method_slot_index(MethodDef const& method) {
+        return vtable_slot(method) - inspectable_slot_count;
     }
 
     IInspectable* query_interface(IInspectable* const instance, TypeDef& interface_type) {
-        winrt::guid interface_guid(get_guid(interface_type));
+        winrt::guid interface_guid(get_iid(interface_type));
 
         IInspectable* interface_pointer;
         auto hr = instance->QueryInterface(interface_guid, reinterpret_cast<void**>(&interface_pointer));
@@ -189,7 +225,10 @@ namespace interop {
                 std::string type_name = std::string(parent_type.TypeNamespace()) + "." + std::string(parent_type.TypeName());
                 std::string method_name = std::string(method.Name());
                 if (get_category(parent_type) != category::interface_type) {
-                    interface_method = get_interface_method(parent_type, (MethodDef&)method, is_static);
+                    interface_method = get_interface_method(parent_type, method, is_static);
+                }
+                else {
+                    interface_method = method;
                 }
 
                 if (!interface_method)
@@ -204,15 +243,11 @@ namespace interop {
                     return E_FAIL;
                 }
 
-                // Next, we need to compute the vtable slot of the method and QI to get the correct
-                // interface pointer in order to obtain the function pointer.
-                uint32_t const method_slot(compute_method_slot_index(interface_method));
+                // Next, we need to QI to get the correct interface pointer in order to obtain the function
+                // pointer.  The vtable slot comes from the slot table, it already accounts for IUnknown and
+                // IInspectable.
                 auto const interface_pointer(query_interface(instance, interface_method.Parent()));
-
-                // We compute the function pointer from the vtable.  '6' is the well-known offset of all
-                // Windows Runtime interface methods (IUnknown has three functions, and IInspectable has
-                // an additional three functions).
-                void const* const fp(compute_function_pointer(interface_pointer, method_slot + 6));
+                void const* const fp(compute_function_pointer(interface_pointer, interface_method));
 
                 // We construct the argument frame, by converting each argument to the correct type and
                 // appending it to an array.  In stdcall, arguments are pushed onto the stack left-to-right.
@@ -226,13 +261,22 @@ namespace interop {
 
 
                 method_signature method_sig{ method };
+
+                // The IIDs of parameterized interface arguments are computed together, rather than one
+                // signature at a time as each argument is converted:
+                std::vector<type_semantics> parameter_types;
+                for (auto&& param : method_sig.params()) {
+                    parameter_types.push_back(get_type_semantics(param.second->Type()));
+                }
+                iid_cache::prepare(parameter_types);
+
                 // Next, we iterate over the arguments and parameters, convert each argument to the correct
                 // parameter type, and push the argument into the frame:
                 auto count = method_sig.params().size();
                 auto p_it = method_sig.params().begin();
                 auto a_it(begin(arguments));
                 for (; p_it != method_sig.params().end() && a_it != end(arguments); ++p_it, ++a_it) {
-                    convert_and_insert(get_type_semantics((*p_it).second->Type()), (*a_it), frame);
+                    convert_and_insert(parameter_types[p_it - method_sig.params().begin()], (*a_it), frame);
                 }
 
                 if (p_it != method_sig.params().end() || a_it != end(arguments)) {
@@ -342,7 +386,7 @@ namespace interop {
                             break;
                         case category::interface_type:
                         case category::class_type: {
-                            const auto value = convert_to_interface(argument, get_guid(type));
+                            const auto value = convert_to_interface(argument, get_iid(type));
                             frame.push(begin_bytes(value), end_bytes(value));
                             break;
                         }
@@ -352,6 +396,10 @@ namespace interop {
                             break;
                         }
                     },
+                    [&](generic_type_instance const& type) {
+                        const auto value = convert_to_interface(argument, get_iid(type));
+                        frame.push(begin_bytes(value), end_bytes(value));
+                    },
                     [](auto) {
                         throw_invalid("type definition expected");
                     });
@@ -399,7 +447,7 @@ namespace interop {
                         return nullptr;
                 }
                 else {
-                    if (!has_attribute(primary_type, "Windows.Foundation.Metadata", "ActivatableAttribute"))
+                    if (!has_attribute(primary_type, known_attribute::activatable))
                         return nullptr;
 
                     auto hr = RoActivateInstance(reinterpret_cast<HSTRING>(winrt::get_abi(winrt::to_hstring(type_name))), &object);
@@ -5,7 +5,9 @@
 #include <wrl.h>
 #include <Windows.ApplicationModel.h>
 #include "interop/interop.h"
+#include "settings.h"
 #include "writer.h"
+#include "watch.h"
 
 using namespace winmd::reader;
 using namespace ABI::Windows::ApplicationModel;
@@ -14,13 +16,138 @@ int main(int argc, char const *argv[]) {
     winrt::init_apartment();
     // winrt::Windows::ApplicationModel::DesignMode::DesignModeEnabled();
 
-    std::vector<std::string> args;
-    for (size_t i = 1; i < argc; i++) {
-        args.push_back(std::string(argv[i]));
+    settings settings;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg{ argv[i] };
+        if (arg == "--jobs" || arg == "-j") {
+            if (++i == argc)
+                throw_invalid("'", arg, "' expects a thread count");
+
+            settings.jobs = std::stoul(argv[i]);
+            continue;
+        }
+
+        if (arg == "--reference" || arg == "-r") {
+            if (++i == argc)
+                throw_invalid("'", arg, "' expects a winmd file");
+
+            settings.reference.push_back(argv[i]);
+            continue;
+        }
+
+        if (arg == "--include" || arg == "--exclude") {
+            if (++i == argc)
+                throw_invalid("'", arg, "' expects a namespace pattern");
+
+            (arg == "--include" ? settings.include : settings.exclude).push_back(argv[i]);
+            continue;
+        }
+
+        if (arg == "--type-map") {
+            if (++i == argc)
+                throw_invalid("'", arg, "' expects a mapping file");
+
+            settings.type_map = argv[i];
+            continue;
+        }
+
+        if (arg == "--force") {
+            settings.incremental = false;
+            continue;
+        }
+
+        if (arg == "--trace") {
+            if (++i == argc)
+                throw_invalid("'", arg, "' expects an output file");
+
+            settings.trace = argv[i];
+            continue;
+        }
+
+        if (arg.substr(0, 9) == "--layout=") {
+            auto layout = arg.substr(9);
+            if (layout == "type")
+                settings.layout = output_layout::per_type;
+            else if (layout == "namespace")
+                settings.layout = output_layout::per_namespace;
+            else if (layout == "bundle")
+                settings.layout = output_layout::bundle;
+            else
+                throw_invalid("unknown layout '", layout, "', expected type, namespace or bundle");
+
+            continue;
+        }
+
+        if (arg == "--declarations-only") {
+            settings.declarations_only = true;
+            continue;
+        }
+
+        if (arg == "--lazy-index") {
+            settings.lazy_index = true;
+            continue;
+        }
+
+        if (arg == "--watch") {
+            settings.watch = true;
+            continue;
+        }
+
+        if (arg == "--no-snapshots") {
+            settings.snapshots = false;
+            continue;
+        }
+
+        if (arg == "--stats") {
+            settings.stats = true;
+            continue;
+        }
+
+        settings.input.push_back(std::string(arg));
+    }
+
+    auto output = std::filesystem::current_path().append("output");
+    auto run = [&]() {
+        writer writer{ settings, output };
+        writer.write();
+        if (settings.watch)
+            writer.retain_indexes();
+
+        if (settings.stats)
+            writer.stats().report(std::cout);
+    };
+
+    if (!settings.watch) {
+        run();
+        return 0;
     }
 
-    writer writer{ args, std::filesystem::current_path().append("output") };
-    writer.write();
+    // watching starts before the first run, so nothing written meanwhile is missed. References are
+    // watched too, a change to one can change every input's projection
+    auto watched = settings.input;
+    watched.insert(watched.end(), settings.reference.begin(), settings.reference.end());
+    file_watcher watcher{ watched };
+    run();
 
-    return 0;
+    // later runs only rewrite what changed, --force applies to the first one
+    settings.incremental = true;
+    while (true) {
+        std::cout << "Watching for changes..." << std::endl;
+        for (auto&& file : watcher.wait()) {
+            std::cout << "Changed " << file.string() << std::endl;
+            settings.changed.push_back(file);
+        }
+
+        writer::release_indexes();
+        try {
+            run();
+
+            // a run that failed leaves its changes to the next one
+            settings.changed.clear();
+        }
+        catch (std::exception const& e) {
+            // most likely a winmd that's still being written, the next change brings a complete one
+            std::cerr << e.what() << std::endl;
+        }
+    }
 }
@@ -0,0 +1,285 @@
+#pragma once
+#include <map>
+#include <mutex>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <winmd_reader.h>
+#include "helpers.h"
+#include "output_sink.h"
+
+using namespace winmd::reader;
+
+// bump this whenever a change to the writer alters the files it emits, so existing manifests are thrown away
+constexpr std::string_view generator_version = "1";
+
+/// 64-bit FNV-1a over everything fed into it
+struct fingerprint {
+    uint64_t value = 14695981039346656037ull;
+
+    void add(std::string_view const& data) {
+        add_bytes(data.data(), data.size());
+        add<uint8_t>(0); // terminate, so "ab" + "c" differs from "a" + "bc"
+    }
+
+    template <typename T>
+    auto add(T const& data) -> std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>> {
+        add_bytes(&data, sizeof(data));
+    }
+
+    void add(type_semantics const& semantics) {
+        add<size_t>(semantics.index());
+        call(
+            semantics,
+            [&](type_definition const& type) {
+                add(type.TypeNamespace());
+                add(type.TypeName());
+
+                // a referenced type is imported, or stubbed with 'any' when it isn't projected
+                add(is_exclusive_to(type));
+                add(has_attribute(type, known_attribute::webhost_hidden));
+            },
+            [&](generic_type_instance const& type) {
+                add(type_semantics{ type.generic_type });
+                for (auto&& arg : type.generic_args()) {
+                    add(arg);
+                }
+            },
+            [&](generic_type_index const& var) { add(var.index); },
+            [&](generic_type_param const& param) { add(param.Name()); },
+            [&](fundamental_type const& type) { add(type); },
+            [](auto) {});
+    }
+
+    void add(TypeSig const& signature) {
+        add(signature.is_szarray());
+        add(signature.is_array());
+        add(get_type_semantics(signature));
+    }
+
+    template <typename T>
+    void add_attributes(T const& row) {
+        for (auto&& attribute : row.CustomAttribute()) {
+            auto [ns, name] = attribute.TypeNamespaceAndName();
+            add(ns);
+            add(name);
+
+            for (auto&& arg : attribute.Value().FixedArgs()) {
+                call(
+                    arg.value,
+                    [&](ElemSig const& elem) { add_elem(elem); },
+                    [&](std::vector<ElemSig> const& elems) {
+                        for (auto&& elem : elems) {
+                            add_elem(elem);
+                        }
+                    });
+            }
+        }
+    }
+
+private:
+    void add_bytes(void const* data, size_t size) {
+        auto bytes = static_cast<uint8_t const*>(data);
+        for (size_t i = 0; i < size; i++) {
+            value ^= bytes[i];
+            value *= 1099511628211ull;
+        }
+    }
+
+    void add_elem(ElemSig const& elem) {
+        std::visit([&](auto const& value) { add_value(value); }, elem.value);
+    }
+
+    template <typename T>
+    void add_value(T const& value) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            add(value);
+        }
+        else if constexpr (std::is_same_v<T, std::string_view>) {
+            add(value);
+        }
+        else if constexpr (std::is_same_v<T, ElemSig::SystemType>) {
+            add(value.name);
+        }
+        else if constexpr (std::is_same_v<T, ElemSig::EnumValue>) {
+            std::visit([&](auto const& underlying) { add(underlying); }, value.value);
+        }
+    }
+};
+
+/// Hashes the metadata that determines the projection of `type`: its own rows, signatures and
+/// attributes, plus the bits of every type it references that decide how that reference is emitted
+inline uint64_t type_fingerprint(TypeDef const& type) {
+    fingerprint fp;
+    fp.add(type.TypeNamespace());
+    fp.add(type.TypeName());
+    fp.add(type.Flags().value);
+    fp.add_attributes(type);
+
+    if (type.Extends()) {
+        fp.add(get_type_semantics(type.Extends()));
+
+        // classes forward unknown listeners to their base when it declares events
+        if (type.Extends().type() == TypeDefOrRef::TypeDef)
+            fp.add(distance(type.Extends().TypeDef().EventList()));
+    }
+
+    for (auto&& param : type.GenericParam()) {
+        fp.add(param.Name());
+    }
+
+    for (auto&& impl : type.InterfaceImpl()) {
+        fp.add(get_type_semantics(impl.Interface()));
+        fp.add_attributes(impl);
+    }
+
+    bool is_flags = has_attribute(type, known_attribute::flags);
+    for (auto&& field : type.FieldList()) {
+        fp.add(field.Name());
+        fp.add(field.Flags().value);
+        fp.add(field.Signature().Type());
+
+        if (auto constant = field.Constant())
+            fp.add(is_flags ? constant.ValueUInt32() : static_cast<uint32_t>(constant.ValueInt32()));
+    }
+
+    for (auto&& method : type.MethodList()) {
+        fp.add(method.Name());
+        fp.add(method.Flags().value);
+        fp.add_attributes(method);
+
+        auto signature = method.Signature();
+        fp.add(static_cast<bool>(signature.ReturnType()));
+        if (signature.ReturnType())
+            fp.add(signature.ReturnType().Type());
+
+        for (auto&& param : signature.Params()) {
+            fp.add(param.ByRef());
+            fp.add(param.Type());
+        }
+
+        for (auto&& param : method.ParamList()) {
+            fp.add(param.Name());
+            fp.add(param.Flags().value);
+            fp.add(param.Sequence());
+        }
+    }
+
+    for (auto&& prop : type.PropertyList()) {
+        fp.add(prop.Name());
+        fp.add(prop.Type().Type());
+        fp.add_attributes(prop);
+    }
+
+    for (auto&& event : type.EventList()) {
+        fp.add(event.Name());
+        fp.add(get_type_semantics(event.EventType()));
+        fp.add_attributes(event);
+    }
+
+    return fp.value;
+}
+
+/// Records which file every projected type was written to, and the fingerprint of the metadata it
+/// was written from, so the next run can skip types that haven't changed.
+///
+/// The manifest is a text file, one type per line:
+///   tswinrt-manifest <generator version> <options>
+///   <fingerprint>\t<namespace.name>\t<file relative to the output directory>
+class manifest {
+public:
+    struct entry {
+        uint64_t fingerprint;
+        std::string file;
+    };
+
+    manifest(std::filesystem::path const& path, std::filesystem::path const& root, std::string const& options) : _path(path), _root(root), _options(options) {
+    }
+
+    /// Reads the previous run's entries, returns false when there's no manifest written under the same options
+    bool load() {
+        std::ifstream in{ _path };
+        if (!in)
+            return false;
+
+        std::string line;
+        if (!std::getline(in, line) || line != header())
+            return false; // written by a different generator or with different options, nothing in it can be trusted
+
+        while (std::getline(in, line)) {
+            auto first = line.find('\t');
+            auto second = line.find('\t', first + 1);
+            if (first == std::string::npos || second == std::string::npos)
+                continue;
+
+            auto& entry = _previous[line.substr(first + 1, second - first - 1)];
+            entry.fingerprint = std::stoull(line.substr(0, first), nullptr, 16);
+            entry.file = line.substr(second + 1);
+        }
+
+        return true;
+    }
+
+    void save() {
+        std::ofstream out{ _path, std::fstream::out | std::fstream::trunc };
+        out << header() << "\n";
+
+        std::lock_guard lock{ _lock };
+        for (auto&& [type_name, entry] : _current) {
+            out << std::hex << std::setw(16) << std::setfill('0') << entry.fingerprint << std::dec << "\t" << type_name << "\t" << entry.file << "\n";
+        }
+    }
+
+    /// Returns true and carries the previous entry over when `type_name` was last written from the
+    /// same fingerprint and its file is still in the output tree, and is `expected` when that's given
+    bool unchanged(std::string const& type_name, uint64_t fingerprint, output_sink const& sink, std::filesystem::path const& expected = {}) {
+        auto it = _previous.find(type_name);
+        if (it == _previous.end() || it->second.fingerprint != fingerprint)
+            return false;
+
+        if (!expected.empty() && it->second.file != expected.lexically_relative(_root).generic_string())
+            return false;
+
+        if (!sink.exists(_root / std::filesystem::path(it->second.file).make_preferred()))
+            return false;
+
+        std::lock_guard lock{ _lock };
+        _current.insert(*it);
+        return true;
+    }
+
+    /// Carries over the previous entries of every type `keep` picks, for the roots a run doesn't visit,
+    /// and returns how many there were
+    template <typename F>
+    size_t carry_over(F&& keep) {
+        size_t kept = 0;
+        std::lock_guard lock{ _lock };
+        for (auto&& entry : _previous) {
+            if (keep(entry.first) && _current.insert(entry).second)
+                kept++;
+        }
+
+        return kept;
+    }
+
+    void record(std::string const& type_name, uint64_t fingerprint, std::filesystem::path const& file) {
+        auto relative = file.lexically_relative(_root).generic_string();
+
+        std::lock_guard lock{ _lock };
+        _current[type_name] = entry{ fingerprint, relative };
+    }
+
+private:
+    std::string header() const {
+        return "tswinrt-manifest " + std::string(generator_version) + " " + _options;
+    }
+
+    std::filesystem::path _path;
+    std::filesystem::path _root;
+    std::string _options;
+    std::map<std::string, entry> _previous;
+    std::map<std::string, entry> _current;
+    std::mutex _lock;
+};
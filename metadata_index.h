@@ -0,0 +1,110 @@
+#pragma once
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <winmd_reader.h>
+
+using namespace winmd::reader;
+
+/// Data derived from a loaded database, computed once and shared by every thread afterwards.
+///
+/// `T` is constructed from a `database const&` the first time it's asked for, build() does that
+/// for every database in a cache up front. Lookups from the same thread for the same database
+/// don't take the lock.
+///
+/// build() can pass `T` more arguments, a filter narrowing what it covers say. A table built on
+/// demand by get() never sees them, so it has to be complete without them.
+template <typename T>
+class database_index {
+public:
+    static T const& get(database const& db) {
+        thread_local database const* last_db = nullptr;
+        thread_local T const* last_table = nullptr;
+        thread_local uint64_t last_generation = 0;
+
+        auto& self = instance();
+        auto generation = self._generation.load(std::memory_order_acquire);
+        if (last_db == &db && last_generation == generation)
+            return *last_table;
+
+        last_table = &self.find_or_build(db);
+        last_db = &db;
+        last_generation = generation;
+        return *last_table;
+    }
+
+    /// Builds the tables of every database in `c`, spread over `jobs` threads
+    static void build(cache const& c, uint32_t jobs = 1) {
+        std::vector<database const*> databases;
+        for (auto&& db : c.databases()) {
+            databases.push_back(&db);
+        }
+
+        build(databases, jobs);
+    }
+
+    /// Builds the tables of `databases`, spread over `jobs` threads, as `T(db, args...)`
+    template <typename... Args>
+    static void build(std::vector<database const*> const& databases, uint32_t jobs, Args const&... args) {
+        std::atomic<size_t> next{ 0 };
+        auto worker = [&]() {
+            for (size_t n = next++; n < databases.size(); n = next++) {
+                instance().find_or_build(*databases[n], args...);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < jobs && i < databases.size(); i++) {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+        for (auto&& thread : threads) {
+            thread.join();
+        }
+    }
+
+    /// Hands over a table made some other way, read from a snapshot say, if `db` doesn't have one yet
+    static void adopt(database const& db, std::unique_ptr<T> table) {
+        auto& self = instance();
+        std::unique_lock lock{ self._lock };
+        self._tables.emplace(&db, std::move(table));
+    }
+
+    /// Drops every table, anything handed out by get() before is invalid afterwards
+    static void clear() {
+        auto& self = instance();
+        std::unique_lock lock{ self._lock };
+        self._tables.clear();
+        self._generation++;
+    }
+
+private:
+    static database_index& instance() {
+        static database_index index;
+        return index;
+    }
+
+    template <typename... Args>
+    T const& find_or_build(database const& db, Args const&... args) {
+        {
+            std::shared_lock lock{ _lock };
+            auto it = _tables.find(&db);
+            if (it != _tables.end())
+                return *it->second;
+        }
+
+        // built outside the lock, if two threads race for the same database the first one wins
+        auto table = std::make_unique<T>(db, args...);
+
+        std::unique_lock lock{ _lock };
+        return *_tables.emplace(&db, std::move(table)).first->second;
+    }
+
+    std::shared_mutex _lock;
+    std::unordered_map<database const*, std::unique_ptr<T>> _tables;
+    std::atomic<uint64_t> _generation{ 1 };
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Picks the namespaces that are projected, from --include and --exclude glob patterns.
+///
+/// '*' matches any run of characters, dots included, and '?' any single one. A pattern ending in
+/// ".*" matches the namespace before it as well, so "Windows.Storage.*" takes Windows.Storage and
+/// everything below it. Without includes every namespace is included, excludes win over includes.
+class namespace_filter {
+public:
+    namespace_filter() = default;
+
+    namespace_filter(std::vector<std::string> include, std::vector<std::string> exclude) : _include(std::move(include)), _exclude(std::move(exclude)) {
+    }
+
+    /// Whether the filter lets every namespace through
+    bool empty() const {
+        return _include.empty() && _exclude.empty();
+    }
+
+    bool matches(std::string_view ns) const {
+        if (!_include.empty() && !any_match(_include, ns))
+            return false;
+
+        return !any_match(_exclude, ns);
+    }
+
+    /// The patterns, as they go into the manifest options
+    std::string to_string() const {
+        std::string s;
+        for (auto&& pattern : _include) {
+            s += ",include=" + pattern;
+        }
+
+        for (auto&& pattern : _exclude) {
+            s += ",exclude=" + pattern;
+        }
+
+        return s;
+    }
+
+    static bool glob(std::string_view pattern, std::string_view text) {
+        if (pattern.size() >= 2 && pattern.substr(pattern.size() - 2) == ".*" && text == pattern.substr(0, pattern.size() - 2))
+            return true;
+
+        // iterative, backtracking only to the last '*'
+        size_t p = 0, t = 0;
+        size_t star = std::string_view::npos, resume = 0;
+        while (t < text.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+                p++;
+                t++;
+            }
+            else if (p < pattern.size() && pattern[p] == '*') {
+                star = p++;
+                resume = t;
+            }
+            else if (star != std::string_view::npos) {
+                p = star + 1;
+                t = ++resume;
+            }
+            else {
+                return false;
+            }
+        }
+
+        while (p < pattern.size() && pattern[p] == '*') {
+            p++;
+        }
+
+        return p == pattern.size();
+    }
+
+private:
+    static bool any_match(std::vector<std::string> const& patterns, std::string_view ns) {
+        for (auto&& pattern : patterns) {
+            if (glob(pattern, ns))
+                return true;
+        }
+
+        return false;
+    }
+
+    std::vector<std::string> _include;
+    std::vector<std::string> _exclude;
+};
@@ -0,0 +1,162 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+#include <winmd_reader.h>
+
+using namespace winmd::reader;
+
+/// Calls `f` with every '.' separated segment of `name`, as views into it
+template <typename F>
+void for_each_segment(std::string_view name, F&& f) {
+    while (!name.empty()) {
+        auto position = name.find('.');
+        f(name.substr(0, position));
+
+        if (position == std::string_view::npos)
+            break;
+
+        name.remove_prefix(position + 1);
+    }
+}
+
+struct namespace_node {
+    std::string_view name;    // the full namespace, "Windows.Foundation"
+    std::string_view segment; // the last part of it, "Foundation"
+    uint32_t depth = 0;       // number of segments, the root is 0
+    namespace_node* parent = nullptr;
+
+    std::filesystem::path path; // the directory its types are written to
+    std::string module_path;    // "Windows/Foundation", how other packages import it
+
+    cache::namespace_members const* members = nullptr; // null when no database declares types in it
+    bool projected = false;                             // whether its types are written out
+    bool contains_projected = false;                    // whether it, or anything below it, is projected
+
+    std::map<std::string_view, std::unique_ptr<namespace_node>> children;
+};
+
+/// Every namespace of a run, split into segments once so moving between namespaces, relative names
+/// and output paths never have to split a string again.
+///
+/// Names are kept as views, whatever is inserted must outlive the trie.
+class namespace_trie {
+public:
+    explicit namespace_trie(std::filesystem::path const& root) {
+        _root.path = root;
+    }
+
+    namespace_node& insert(std::string_view const& name) {
+        auto node = &_root;
+        size_t length = 0;
+
+        for_each_segment(name, [&](std::string_view segment) {
+            length += (length != 0 ? 1 : 0) + segment.size();
+
+            auto& child = node->children[segment];
+            if (!child) {
+                child = std::make_unique<namespace_node>();
+                child->name = name.substr(0, length);
+                child->segment = segment;
+                child->depth = node->depth + 1;
+                child->parent = node;
+                child->path = node->path / std::string(segment);
+                child->module_path = node->module_path.empty() ? std::string(segment) : node->module_path + "/" + std::string(segment);
+                _index.emplace(child->name, child.get());
+            }
+
+            node = child.get();
+        });
+
+        return *node;
+    }
+
+    void mark_projected(namespace_node& node) {
+        node.projected = true;
+        for (auto n = &node; n && !n->contains_projected; n = n->parent) {
+            n->contains_projected = true;
+        }
+    }
+
+    namespace_node const* find(std::string_view const& name) const {
+        auto it = _index.find(name);
+        return it != _index.end() ? it->second : nullptr;
+    }
+
+    namespace_node const& root() const {
+        return _root;
+    }
+
+    /// Calls `f` with every node in namespace order, parents before their children
+    template <typename F>
+    void visit(F&& f) const {
+        visit(_root, f);
+    }
+
+    static namespace_node const& common_ancestor(namespace_node const& a, namespace_node const& b) {
+        namespace_node const* x = &a;
+        namespace_node const* y = &b;
+        while (x->depth > y->depth)
+            x = x->parent;
+
+        while (y->depth > x->depth)
+            y = y->parent;
+
+        while (x != y) {
+            x = x->parent;
+            y = y->parent;
+        }
+
+        return *x;
+    }
+
+    /// The segments of `to` below `from`, outermost first
+    static std::vector<std::string_view> segments_below(namespace_node const& from, namespace_node const& to) {
+        std::vector<std::string_view> segments(to.depth - from.depth);
+        namespace_node const* node = &to;
+        for (size_t i = segments.size(); i > 0; i--, node = node->parent) {
+            segments[i - 1] = node->segment;
+        }
+
+        return segments;
+    }
+
+    /// The import path of `file` in `to`, from a file in `from`: "./X", "../Foundation/X"
+    static std::string relative_path(namespace_node const& from, namespace_node const& to, std::string_view const& file) {
+        auto& common = common_ancestor(from, to);
+
+        std::string path;
+        if (from.depth == common.depth) {
+            path = "./";
+        }
+        else {
+            for (auto i = common.depth; i < from.depth; i++) {
+                path += "../";
+            }
+        }
+
+        for (auto&& segment : segments_below(common, to)) {
+            path += segment;
+            path += "/";
+        }
+
+        path += file;
+        return path;
+    }
+
+private:
+    template <typename F>
+    static void visit(namespace_node const& node, F& f) {
+        for (auto&& [segment, child] : node.children) {
+            f(*child);
+            visit(*child, f);
+        }
+    }
+
+    namespace_node _root;
+    std::unordered_map<std::string_view, namespace_node*> _index;
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <set>
+#include <map>
+#include <mutex>
+#include <string>
+#include <fstream>
+#include <filesystem>
+
+/// Holds the files of a run in memory and writes them out in a single pass once projection is done.
+///
+/// The output tree is scanned once up front for files that weren't generated by us (anything not
+/// starting with a "//" comment), so nothing has to touch the filesystem while types are emitted.
+class output_sink {
+public:
+    explicit output_sink(std::filesystem::path const& root) : _root(root) {
+        scan();
+    }
+
+    /// Picks the file generated output for `path` goes to. Hand-written files are left alone and the
+    /// output goes next to them as .gen.ts (or .gen.d.ts) instead.
+    std::filesystem::path resolve(std::filesystem::path path) const {
+        if (_handwritten.find(path) == _handwritten.end())
+            return path;
+
+        if (is_declaration(path))
+            return path.replace_filename(path.filename().string().substr(0, path.filename().string().size() - 5) + ".gen.d.ts");
+
+        return path.replace_extension(".gen.ts");
+    }
+
+    /// Whether `path` was in the output tree when the run started
+    bool exists(std::filesystem::path const& path) const {
+        return _existing.find(path) != _existing.end();
+    }
+
+    /// Queues `contents` to be written to `path`, safe to call from any worker
+    void stage(std::filesystem::path const& path, std::string contents) {
+        std::lock_guard lock{ _lock };
+        _files[path] = std::move(contents);
+    }
+
+    /// What a commit wrote out
+    struct summary {
+        size_t files = 0;
+        size_t created = 0; // files that weren't in the output tree before
+        size_t bytes = 0;
+    };
+
+    /// Writes out everything staged so far, creating each directory once
+    summary commit() {
+        std::lock_guard lock{ _lock };
+
+        summary result;
+
+        std::set<std::filesystem::path> directories;
+        for (auto&& [path, contents] : _files) {
+            directories.insert(path.parent_path());
+        }
+
+        for (auto&& directory : directories) {
+            std::filesystem::create_directories(directory);
+        }
+
+        // switching between .ts and .d.ts output leaves the other kind behind, and TypeScript would
+        // still pick X.ts over X.d.ts, so a generated counterpart that isn't written again goes
+        for (auto&& [path, contents] : _files) {
+            auto other = counterpart(path);
+            if (exists(other) && _handwritten.find(other) == _handwritten.end() && _files.find(other) == _files.end()) {
+                std::error_code ec;
+                std::filesystem::remove(other, ec);
+                _existing.erase(other);
+            }
+        }
+
+        for (auto&& [path, contents] : _files) {
+            // text mode, so line endings come out the same as they did when we streamed straight to disk
+            std::ofstream out{ path, std::fstream::out | std::fstream::trunc };
+            out.write(contents.data(), contents.size());
+
+            result.files++;
+            result.bytes += contents.size();
+            if (!exists(path))
+                result.created++;
+        }
+
+        _files.clear();
+        return result;
+    }
+
+private:
+    static bool is_declaration(std::filesystem::path const& path) {
+        auto name = path.filename().string();
+        return name.size() > 5 && name.compare(name.size() - 5, 5, ".d.ts") == 0;
+    }
+
+    // X.ts for X.d.ts and the other way around
+    static std::filesystem::path counterpart(std::filesystem::path path) {
+        auto name = path.filename().string();
+        if (is_declaration(path))
+            return path.replace_filename(name.substr(0, name.size() - 5) + ".ts");
+
+        return path.replace_filename(name.substr(0, name.size() - 3) + ".d.ts");
+    }
+
+    void scan() {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(_root, ec))
+            return;
+
+        for (auto&& entry : std::filesystem::recursive_directory_iterator(_root, ec)) {
+            if (!entry.is_regular_file())
+                continue;
+
+            _existing.insert(entry.path());
+            if (entry.path().extension() != ".ts" || entry.file_size() == 0)
+                continue;
+
+            char header[2]{};
+            std::ifstream in{ entry.path(), std::fstream::in | std::fstream::binary };
+            in.read(header, sizeof(header));
+
+            if (header[0] != '/' || header[1] != '/')
+                _handwritten.insert(entry.path());
+        }
+    }
+
+    std::filesystem::path _root;
+    std::set<std::filesystem::path> _existing;
+    std::set<std::filesystem::path> _handwritten;
+    std::map<std::filesystem::path, std::string> _files;
+    std::mutex _lock;
+};
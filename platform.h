@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+// The generator runs on Windows, where it activates the types it projects. Everything that only
+// reads metadata builds elsewhere too (the benchmarks do), with the little it needs filled in here.
+#ifdef _WIN32
+#include <windows.h>
+#include <winrt/base.h>
+#else
+namespace winrt {
+    struct guid {
+        uint32_t Data1;
+        uint16_t Data2;
+        uint16_t Data3;
+        uint8_t Data4[8];
+    };
+}
+#endif
+
+/// The local time formatted like ctime(), newline included
+inline std::string format_time(std::time_t time) {
+    char str[26];
+#ifdef _WIN32
+    ctime_s(str, sizeof str, &time);
+#else
+    ctime_r(&time, str);
+#endif
+    return str;
+}
+
+/// CPU time used so far by every thread of the process, in seconds
+inline double process_cpu_seconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0;
+
+    auto ticks = [](FILETIME const& time) { return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) / 1e7;
+#else
+    timespec now{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/// How the projected types are split into files
+enum class output_layout {
+    per_type,      // a module per type, re-exported from index.ts
+    per_namespace, // a module per namespace, re-exported from index.ts
+    bundle,        // everything in index.ts, nested in namespace blocks
+};
+
+struct settings {
+    // winmd files (or directories of them) to project, each into its own directory under the output
+    std::vector<std::string> input;
+
+    // winmd files loaded only so the inputs' references to them resolve
+    std::vector<std::string> reference;
+
+    // glob patterns of the namespaces to project, and of the ones to leave out of them
+    std::vector<std::string> include;
+    std::vector<std::string> exclude;
+
+    // number of worker threads used to project namespaces, 0 picks one per hardware thread
+    uint32_t jobs = 1;
+
+    // skip types whose metadata hasn't changed since the manifest next to the output directory was written
+    bool incremental = true;
+
+    // keep running after the first projection, and project again whenever an input changes
+    bool watch = false;
+
+    // set by --watch, the winmd files that changed since the last projection, only the inputs among
+    // them are projected again unless a reference changed too. Empty projects every input
+    std::vector<std::filesystem::path> changed;
+
+    // keep the tables derived from each winmd next to the output, and read them back while it's unchanged
+    bool snapshots = true;
+
+    output_layout layout = output_layout::per_type;
+
+    // .d.ts files with the types alone, for consumers that only type check against the projection
+    bool declarations_only = false;
+
+    // an index.ts that loads each type's module the first time the type is read, rather than all of them up front
+    bool lazy_index = false;
+
+    // a file of extra type mappings, each line mapping a type to the TypeScript type it projects as
+    std::string type_map;
+
+    // print how long each phase took and what was written once the run is done
+    bool stats = false;
+
+    // where to write a Chrome trace-event timeline of the run, nothing is traced when empty
+    std::string trace;
+};
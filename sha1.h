@@ -0,0 +1,206 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TSWINRT_SHA1_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using sha1_digest = std::array<uint8_t, 20>;
+
+namespace sha1_impl {
+    inline uint32_t rol(uint32_t value, int bits) {
+        return (value << bits) | (value >> (32 - bits));
+    }
+
+    inline uint32_t load_be32(uint8_t const* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+
+    inline void store_be32(uint8_t* p, uint32_t value) {
+        p[0] = uint8_t(value >> 24);
+        p[1] = uint8_t(value >> 16);
+        p[2] = uint8_t(value >> 8);
+        p[3] = uint8_t(value);
+    }
+
+    constexpr uint32_t initial_state[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    constexpr uint32_t round_constants[4] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
+
+    /// `message` followed by the SHA-1 padding, a whole number of 64 byte blocks
+    inline std::vector<uint8_t> pad(std::string_view const& message) {
+        size_t size = (message.size() + 1 + 8 + 63) / 64 * 64;
+        std::vector<uint8_t> padded(size);
+        std::copy(message.begin(), message.end(), padded.begin());
+        padded[message.size()] = 0x80;
+
+        uint64_t bits = uint64_t(message.size()) * 8;
+        for (size_t i = 0; i < 8; i++) {
+            padded[size - 1 - i] = uint8_t(bits >> (i * 8));
+        }
+
+        return padded;
+    }
+
+    inline void compress(uint32_t state[5], uint8_t const* block) {
+        uint32_t w[80];
+        for (int t = 0; t < 16; t++) {
+            w[t] = load_be32(block + t * 4);
+        }
+
+        for (int t = 16; t < 80; t++) {
+            w[t] = rol(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int t = 0; t < 80; t++) {
+            uint32_t f;
+            if (t < 20)
+                f = d ^ (b & (c ^ d));
+            else if (t < 40 || t >= 60)
+                f = b ^ c ^ d;
+            else
+                f = (b & c) | (d & (b | c));
+
+            uint32_t temp = rol(a, 5) + f + e + round_constants[t / 20] + w[t];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+    inline sha1_digest finish(uint32_t const state[5]) {
+        sha1_digest digest;
+        for (int i = 0; i < 5; i++) {
+            store_be32(digest.data() + i * 4, state[i]);
+        }
+
+        return digest;
+    }
+
+#ifdef TSWINRT_SHA1_SSE2
+    inline __m128i rol(__m128i value, int bits) {
+        return _mm_or_si128(_mm_slli_epi32(value, bits), _mm_srli_epi32(value, 32 - bits));
+    }
+
+    /// Runs one block of four independent messages through the compression function, one per lane
+    inline void compress4(__m128i state[5], uint8_t const* const blocks[4]) {
+        __m128i w[80];
+        for (int t = 0; t < 16; t++) {
+            w[t] = _mm_setr_epi32(
+                int(load_be32(blocks[0] + t * 4)),
+                int(load_be32(blocks[1] + t * 4)),
+                int(load_be32(blocks[2] + t * 4)),
+                int(load_be32(blocks[3] + t * 4)));
+        }
+
+        for (int t = 16; t < 80; t++) {
+            w[t] = rol(_mm_xor_si128(_mm_xor_si128(w[t - 3], w[t - 8]), _mm_xor_si128(w[t - 14], w[t - 16])), 1);
+        }
+
+        __m128i a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int t = 0; t < 80; t++) {
+            __m128i f;
+            if (t < 20)
+                f = _mm_xor_si128(d, _mm_and_si128(b, _mm_xor_si128(c, d)));
+            else if (t < 40 || t >= 60)
+                f = _mm_xor_si128(_mm_xor_si128(b, c), d);
+            else
+                f = _mm_or_si128(_mm_and_si128(b, c), _mm_and_si128(d, _mm_or_si128(b, c)));
+
+            auto k = _mm_set1_epi32(int(round_constants[t / 20]));
+            auto temp = _mm_add_epi32(_mm_add_epi32(rol(a, 5), f), _mm_add_epi32(_mm_add_epi32(e, k), w[t]));
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        state[0] = _mm_add_epi32(state[0], a);
+        state[1] = _mm_add_epi32(state[1], b);
+        state[2] = _mm_add_epi32(state[2], c);
+        state[3] = _mm_add_epi32(state[3], d);
+        state[4] = _mm_add_epi32(state[4], e);
+    }
+#endif
+}
+
+inline sha1_digest sha1(std::string_view const& message) {
+    auto padded = sha1_impl::pad(message);
+
+    uint32_t state[5];
+    std::copy(std::begin(sha1_impl::initial_state), std::end(sha1_impl::initial_state), state);
+    for (size_t offset = 0; offset < padded.size(); offset += 64) {
+        sha1_impl::compress(state, padded.data() + offset);
+    }
+
+    return sha1_impl::finish(state);
+}
+
+/// Hashes every message in `messages`. With SSE2 four messages go through the compression
+/// function at once, one per lane, which is where the time goes for short messages.
+inline std::vector<sha1_digest> sha1_batch(std::vector<std::string_view> const& messages) {
+    std::vector<sha1_digest> digests(messages.size());
+    size_t i = 0;
+
+#ifdef TSWINRT_SHA1_SSE2
+    static uint8_t const idle_block[64]{};
+
+    for (; i + 4 <= messages.size(); i += 4) {
+        std::vector<uint8_t> padded[4];
+        size_t blocks = 0;
+        for (size_t lane = 0; lane < 4; lane++) {
+            padded[lane] = sha1_impl::pad(messages[i + lane]);
+            blocks = (std::max)(blocks, padded[lane].size() / 64);
+        }
+
+        __m128i state[5];
+        for (int n = 0; n < 5; n++) {
+            state[n] = _mm_set1_epi32(int(sha1_impl::initial_state[n]));
+        }
+
+        for (size_t block = 0; block < blocks; block++) {
+            // lanes that ran out of blocks keep hashing an idle one, their digest was taken already
+            uint8_t const* inputs[4];
+            for (size_t lane = 0; lane < 4; lane++) {
+                inputs[lane] = block * 64 < padded[lane].size() ? padded[lane].data() + block * 64 : idle_block;
+            }
+
+            sha1_impl::compress4(state, inputs);
+
+            for (size_t lane = 0; lane < 4; lane++) {
+                if (padded[lane].size() != (block + 1) * 64)
+                    continue;
+
+                alignas(16) uint32_t lanes[5][4];
+                uint32_t words[5];
+                for (int n = 0; n < 5; n++) {
+                    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[n]), state[n]);
+                    words[n] = lanes[n][lane];
+                }
+
+                digests[i + lane] = sha1_impl::finish(words);
+            }
+        }
+    }
+#endif
+
+    for (; i < messages.size(); i++) {
+        digests[i] = sha1(messages[i]);
+    }
+
+    return digests;
+}
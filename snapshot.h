@@ -0,0 +1,361 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// bump this whenever a table changes what it writes into a snapshot, older snapshots are rebuilt
+constexpr uint32_t snapshot_version = 1;
+
+/// A file mapped read-only into memory for as long as anything holds on to it
+class mapped_file {
+public:
+    explicit mapped_file(std::filesystem::path const& path) {
+#ifdef _WIN32
+        _file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("can't open " + path.string());
+
+        LARGE_INTEGER size{};
+        GetFileSizeEx(_file, &size);
+        _size = static_cast<size_t>(size.QuadPart);
+        if (_size == 0)
+            return;
+
+        _mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping == nullptr)
+            throw std::runtime_error("can't map " + path.string());
+
+        _data = static_cast<char const*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        _fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (_fd < 0)
+            throw std::runtime_error("can't open " + path.string());
+
+        struct stat st {};
+        fstat(_fd, &st);
+        _size = static_cast<size_t>(st.st_size);
+        if (_size == 0)
+            return;
+
+        auto data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+        _data = data != MAP_FAILED ? static_cast<char const*>(data) : nullptr;
+#endif
+        if (_data == nullptr)
+            throw std::runtime_error("can't map " + path.string());
+    }
+
+    /// Holds `data` in memory instead, for tables that are kept without ever being written out
+    explicit mapped_file(std::vector<char> data) : _buffer(std::move(data)) {
+        _data = _buffer.data();
+        _size = _buffer.size();
+    }
+
+    ~mapped_file() {
+#ifdef _WIN32
+        if (_data && _mapping)
+            UnmapViewOfFile(_data);
+        if (_mapping)
+            CloseHandle(_mapping);
+        if (_file != INVALID_HANDLE_VALUE)
+            CloseHandle(_file);
+#else
+        if (_data && _fd >= 0)
+            munmap(const_cast<char*>(_data), _size);
+        if (_fd >= 0)
+            close(_fd);
+#endif
+    }
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    char const* data() const { return _data; }
+    size_t size() const { return _size; }
+
+private:
+    char const* _data = nullptr;
+    size_t _size = 0;
+    std::vector<char> _buffer;
+#ifdef _WIN32
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#else
+    int _fd = -1;
+#endif
+};
+
+using module_id = std::array<uint8_t, 16>;
+
+/// The MVID of a metadata file, the first GUID of its #GUID heap, or nothing when it doesn't look like one.
+/// The reader doesn't expose the Module table's Mvid column, so this walks the PE image itself.
+inline bool read_module_id(char const* data, size_t size, module_id& mvid) {
+    auto u16 = [&](size_t offset) { uint16_t v; std::memcpy(&v, data + offset, 2); return v; };
+    auto u32 = [&](size_t offset) { uint32_t v; std::memcpy(&v, data + offset, 4); return v; };
+
+    if (size < 0x40 || data[0] != 'M' || data[1] != 'Z')
+        return false;
+
+    size_t pe = u32(0x3c);
+    if (pe + 24 > size || std::memcmp(data + pe, "PE\0\0", 4) != 0)
+        return false;
+
+    size_t sections = u16(pe + 6);
+    size_t optional = pe + 24;
+    size_t section_table = optional + u16(pe + 20);
+    size_t directories = optional + (u16(optional) == 0x20b ? 112 : 96);
+    if (directories + 15 * 8 > size || section_table + sections * 40 > size)
+        return false;
+
+    auto offset_of = [&](uint32_t rva, size_t& offset) {
+        for (size_t i = 0; i < sections; i++) {
+            auto section = section_table + i * 40;
+            auto address = u32(section + 12);
+            if (rva >= address && rva < address + u32(section + 16)) {
+                offset = rva - address + u32(section + 20);
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    // the CLI header is the fifteenth data directory, the metadata root hangs off it
+    size_t cli = 0, root = 0;
+    if (!offset_of(u32(directories + 14 * 8), cli) || cli + 16 > size || !offset_of(u32(cli + 8), root) || root + 16 > size)
+        return false;
+
+    if (u32(root) != 0x424a5342)
+        return false;
+
+    size_t stream = root + 16 + u32(root + 12) + 4;
+    if (stream > size)
+        return false;
+
+    size_t streams = u16(stream - 2);
+    for (size_t i = 0; i < streams && stream + 8 < size; i++) {
+        auto offset = u32(stream);
+        auto name = data + stream + 8;
+        auto name_length = strnlen(name, size - stream - 8);
+        if (std::string_view(name, name_length) == "#GUID") {
+            if (root + offset + 16 > size)
+                return false;
+
+            std::memcpy(mvid.data(), data + root + offset, 16);
+            return true;
+        }
+
+        stream += 8 + ((name_length + 4) & ~size_t(3));
+    }
+
+    return false;
+}
+
+/// Serialises derived tables into the snapshot format: plain little-endian values, every array
+/// prefixed with its length and aligned to 8 bytes, so a mapped snapshot can be read in place
+class snapshot_writer {
+public:
+    template <typename T>
+    void write(T const& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto bytes = reinterpret_cast<char const*>(&value);
+        _data.insert(_data.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    void write_array(T const* values, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write<uint64_t>(count);
+        auto bytes = reinterpret_cast<char const*>(values);
+        _data.insert(_data.end(), bytes, bytes + count * sizeof(T));
+        align();
+    }
+
+    template <typename T>
+    void write_array(std::vector<T> const& values) {
+        write_array(values.data(), values.size());
+    }
+
+    std::vector<char> const& data() const { return _data; }
+
+private:
+    void align() {
+        _data.resize((_data.size() + 7) & ~size_t(7));
+    }
+
+    std::vector<char> _data;
+};
+
+/// Reads back what snapshot_writer wrote, arrays are handed out as views into the mapping.
+/// Anything running past the end throws, a damaged snapshot is simply rebuilt.
+class snapshot_reader {
+public:
+    snapshot_reader(std::shared_ptr<mapped_file const> file, size_t offset) : _file(std::move(file)), _offset(offset) {
+    }
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    std::pair<T const*, size_t> read_array() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto count = read<uint64_t>();
+        if (count > _file->size() / sizeof(T))
+            throw std::runtime_error("snapshot truncated");
+
+        auto values = reinterpret_cast<T const*>(take(count * sizeof(T)));
+        take(((_offset + 7) & ~size_t(7)) - _offset);
+        return { values, static_cast<size_t>(count) };
+    }
+
+    /// Keeps the mapping alive for whatever holds views into it
+    std::shared_ptr<mapped_file const> const& file() const { return _file; }
+
+private:
+    char const* take(size_t size) {
+        if (_offset + size > _file->size())
+            throw std::runtime_error("snapshot truncated");
+
+        auto data = _file->data() + _offset;
+        _offset += size;
+        return data;
+    }
+
+    std::shared_ptr<mapped_file const> _file;
+    size_t _offset;
+};
+
+/// Where the snapshot of a database goes, and whether the one there was written for it.
+///
+/// A snapshot is keyed by the MVID and size of the winmd it was derived from, both in its name
+/// and in its header, and holds whatever tables were saved into it in a fixed order.
+class snapshot_file {
+public:
+    snapshot_file(std::filesystem::path const& directory, std::string const& winmd) {
+        mapped_file source{ winmd };
+        _size = source.size();
+        _valid = read_module_id(source.data(), source.size(), _mvid);
+
+        static constexpr char digits[] = "0123456789abcdef";
+        std::string name;
+        for (auto byte : _mvid) {
+            name += digits[byte >> 4];
+            name += digits[byte & 15];
+        }
+
+        _stem = std::filesystem::path(winmd).stem().string();
+        _path = directory / (_stem + "-" + name + "-" + std::to_string(_size) + ".snapshot");
+        _key = std::filesystem::absolute(winmd).lexically_normal().string() + "|" + _path.filename().string();
+    }
+
+    /// False when the winmd has no MVID to key a snapshot by
+    bool keyed() const { return _valid; }
+
+    /// The winmd's full path along with its MVID and size, what its tables are kept in memory under
+    std::string const& key() const { return _key; }
+
+    /// Opens the snapshot for reading, positioned after its header, or nothing when there isn't a
+    /// matching one
+    std::unique_ptr<snapshot_reader> open() const {
+        std::error_code ec;
+        if (!_valid || !std::filesystem::exists(_path, ec))
+            return nullptr;
+
+        auto reader = std::make_unique<snapshot_reader>(std::make_shared<mapped_file const>(_path), 0);
+        auto header = reader->read<snapshot_header>();
+        if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != snapshot_version || header.mvid != _mvid || header.size != _size)
+            return nullptr;
+
+        return reader;
+    }
+
+    /// Writes `body` out under a header, going through a temporary file so a reader never sees half of it
+    void save(snapshot_writer const& body) const {
+        if (!_valid)
+            return;
+
+        snapshot_header header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = snapshot_version;
+        header.mvid = _mvid;
+        header.size = _size;
+
+        std::filesystem::create_directories(_path.parent_path());
+        auto temporary = std::filesystem::path(_path).concat(".tmp");
+        {
+            std::ofstream out{ temporary, std::fstream::out | std::fstream::binary | std::fstream::trunc };
+            out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+            out.write(body.data().data(), body.data().size());
+        }
+
+        std::filesystem::rename(temporary, _path);
+        remove_stale();
+    }
+
+private:
+    // snapshots of earlier versions of the same winmd are never read again, a rebuild replaces them
+    void remove_stale() const {
+        std::error_code ec;
+        for (auto&& entry : std::filesystem::directory_iterator(_path.parent_path(), ec)) {
+            if (entry.path() != _path && is_snapshot_of_stem(entry.path().filename().string()))
+                std::filesystem::remove(entry.path(), ec);
+        }
+    }
+
+    // "<stem>-<32 hex digits>-<size>.snapshot", strictly, so another winmd whose name starts with ours isn't caught
+    bool is_snapshot_of_stem(std::string const& name) const {
+        constexpr std::string_view extension = ".snapshot";
+        if (name.size() < _stem.size() + 35 + extension.size() || name.compare(0, _stem.size(), _stem) != 0 || name[_stem.size()] != '-')
+            return false;
+
+        if (name.compare(name.size() - extension.size(), extension.size(), extension) != 0)
+            return false;
+
+        auto mvid = std::string_view(name).substr(_stem.size() + 1, 32);
+        auto size = std::string_view(name).substr(_stem.size() + 33);
+        size = size.substr(0, size.size() - extension.size());
+        if (mvid.find_first_not_of("0123456789abcdef") != std::string_view::npos || size.size() < 2 || size[0] != '-')
+            return false;
+
+        return size.substr(1).find_first_not_of("0123456789") == std::string_view::npos;
+    }
+
+    static constexpr char magic[8] = { 't', 's', 'w', 'i', 'n', 'r', 't', 's' };
+
+    struct snapshot_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        module_id mvid;
+        uint64_t size;
+    };
+
+    static_assert(sizeof(snapshot_header) % 8 == 0);
+
+    std::filesystem::path _path;
+    std::string _stem;
+    std::string _key;
+    module_id _mvid{};
+    uint64_t _size = 0;
+    bool _valid = false;
+};
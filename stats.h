@@ -0,0 +1,150 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <winmd_reader.h>
+#include "platform.h"
+
+using namespace winmd::reader;
+
+/// What a run spent its time on and what it produced, printed by --stats.
+///
+/// Counters can be bumped from any worker, phases are timed on the thread that drives the run.
+class run_stats {
+public:
+    enum class counter {
+        skipped_types,      // left out by should_project_type
+        unchanged_types,    // carried over from the manifest
+        failing_types,      // at least one property getter failed when invoked
+        failed_invocations, // property getters that failed
+        overloaded_methods, // renamed by OverloadAttribute
+        dropped_overloads,  // overloads whose projected name was taken already
+        snapshots_loaded,   // databases whose derived tables were read back from a snapshot
+        tables_retained,    // databases whose derived tables were kept from the last run of --watch
+        files_written,
+        files_created,
+        bytes_written,
+        count
+    };
+
+    static constexpr size_t category_count = static_cast<size_t>(category::delegate_type) + 1;
+
+    /// Times the enclosing scope as one phase of the run
+    class scoped_phase {
+    public:
+        scoped_phase(run_stats& owner, std::string name) :
+            _owner(owner), _name(std::move(name)), _wall(std::chrono::steady_clock::now()), _cpu(process_cpu_seconds()) {
+        }
+
+        ~scoped_phase() {
+            end();
+        }
+
+        /// Stops the clock before the scope is left
+        void end() {
+            if (_ended)
+                return;
+
+            _ended = true;
+            std::chrono::duration<double> wall = std::chrono::steady_clock::now() - _wall;
+            _owner.add_phase(_name, wall.count(), process_cpu_seconds() - _cpu);
+        }
+
+        scoped_phase(scoped_phase const&) = delete;
+        scoped_phase& operator=(scoped_phase const&) = delete;
+
+    private:
+        run_stats& _owner;
+        std::string _name;
+        std::chrono::steady_clock::time_point _wall;
+        double _cpu;
+        bool _ended = false;
+    };
+
+    [[nodiscard]] scoped_phase phase(std::string name) {
+        return { *this, std::move(name) };
+    }
+
+    void count(counter c, uint64_t n = 1) {
+        _counters[static_cast<size_t>(c)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t get(counter c) const {
+        return _counters[static_cast<size_t>(c)].load(std::memory_order_relaxed);
+    }
+
+    /// Records a type projected into `ns`
+    void count_type(std::string_view ns, category c) {
+        std::lock_guard lock{ _lock };
+        _namespaces[std::string(ns)][static_cast<size_t>(c)]++;
+    }
+
+    void report(std::ostream& out) const {
+        std::lock_guard lock{ _lock };
+
+        out << std::fixed << std::setprecision(1);
+        out << std::left << std::setw(32) << "phase" << std::right << std::setw(12) << "wall ms" << std::setw(12) << "cpu ms" << "\n";
+
+        double wall = 0, cpu = 0;
+        for (auto&& p : _phases) {
+            out << std::left << std::setw(32) << p.name << std::right << std::setw(12) << p.wall * 1000 << std::setw(12) << p.cpu * 1000 << "\n";
+            wall += p.wall;
+            cpu += p.cpu;
+        }
+        out << std::left << std::setw(32) << "total" << std::right << std::setw(12) << wall * 1000 << std::setw(12) << cpu * 1000 << "\n\n";
+
+        static constexpr std::array<char const*, category_count> category_names{ "interface", "class", "enum", "struct", "delegate" };
+        out << std::left << std::setw(48) << "namespace" << std::right;
+        for (auto&& name : category_names) {
+            out << std::setw(11) << name;
+        }
+        out << "\n";
+
+        std::array<uint64_t, category_count> totals{};
+        for (auto&& [ns, counts] : _namespaces) {
+            out << std::left << std::setw(48) << ns << std::right;
+            for (size_t i = 0; i < category_count; i++) {
+                out << std::setw(11) << counts[i];
+                totals[i] += counts[i];
+            }
+            out << "\n";
+        }
+
+        uint64_t written = 0;
+        out << std::left << std::setw(48) << "total" << std::right;
+        for (auto&& total : totals) {
+            out << std::setw(11) << total;
+            written += total;
+        }
+        out << "\n\n";
+
+        out << "types: " << written << " written, " << get(counter::unchanged_types) << " unchanged, " << get(counter::skipped_types) << " skipped, "
+            << get(counter::failing_types) << " failing (" << get(counter::failed_invocations) << " failed getter invocations)\n";
+        out << "methods: " << get(counter::overloaded_methods) << " renamed by overload, " << get(counter::dropped_overloads) << " dropped as duplicate overloads\n";
+        out << "snapshots: " << get(counter::snapshots_loaded) << " loaded, " << get(counter::tables_retained) << " kept from the last run\n";
+        out << "files: " << get(counter::files_written) << " written, " << get(counter::files_created) << " created, " << get(counter::bytes_written) << " bytes\n";
+    }
+
+private:
+    struct phase_time {
+        std::string name;
+        double wall;
+        double cpu;
+    };
+
+    void add_phase(std::string const& name, double wall, double cpu) {
+        std::lock_guard lock{ _lock };
+        _phases.push_back({ name, wall, cpu });
+    }
+
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(counter::count)> _counters{};
+    std::map<std::string, std::array<uint64_t, category_count>> _namespaces;
+    std::vector<phase_time> _phases;
+    mutable std::mutex _lock;
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Collects spans in the Chrome trace-event format, written out by --trace for chrome://tracing or Perfetto.
+///
+/// Spans are complete ("X") events stamped with the thread that ran them, so the timeline shows
+/// one track per worker.
+class trace_log {
+public:
+    trace_log() : _epoch(std::chrono::steady_clock::now()) {
+    }
+
+    /// Records the enclosing scope as a span, does nothing when there's no log to record into
+    class span {
+    public:
+        span(trace_log* owner, std::string_view category, std::string_view name) :
+            _owner(owner), _category(category) {
+            if (!_owner)
+                return;
+
+            // only copied when it's recorded
+            _name = name;
+            _tid = _owner->thread_id();
+            _start = _owner->now();
+        }
+
+        ~span() {
+            if (_owner)
+                _owner->add({ _category, std::move(_name), _start, _owner->now() - _start, _tid });
+        }
+
+        span(span const&) = delete;
+        span& operator=(span const&) = delete;
+
+    private:
+        trace_log* _owner;
+        std::string_view _category;
+        std::string _name;
+        double _start = 0;
+        uint32_t _tid = 0;
+    };
+
+    void save(std::filesystem::path const& path) const {
+        std::lock_guard lock{ _lock };
+
+        std::ofstream out{ path, std::fstream::out | std::fstream::trunc };
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+        // name the tracks so the main thread is told apart from the workers
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}";
+        for (uint32_t tid = 2; tid <= _threads; tid++) {
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":\"worker " << tid - 1 << "\"}}";
+        }
+
+        out.precision(3);
+        out << std::fixed;
+        for (auto&& e : _events) {
+            out << ",\n{\"name\":\"";
+            escape(out, e.name);
+            out << "\",\"cat\":\"" << e.category << "\",\"ph\":\"X\",\"ts\":" << e.start << ",\"dur\":" << e.duration << ",\"pid\":1,\"tid\":" << e.tid << "}";
+        }
+
+        out << "\n]}\n";
+    }
+
+private:
+    struct event {
+        std::string_view category;
+        std::string name;
+        double start; // microseconds since the log was created
+        double duration;
+        uint32_t tid;
+    };
+
+    double now() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _epoch).count();
+    }
+
+    // small, stable ids in the order threads first record something, std::thread::id doesn't print as a number everywhere
+    uint32_t thread_id() {
+        thread_local trace_log const* owner = nullptr;
+        thread_local uint32_t id = 0;
+        if (owner != this) {
+            owner = this;
+            id = ++_threads;
+        }
+
+        return id;
+    }
+
+    void add(event e) {
+        std::lock_guard lock{ _lock };
+        _events.push_back(std::move(e));
+    }
+
+    static void escape(std::ostream& out, std::string_view s) {
+        for (auto c : s) {
+            if (c == '"' || c == '\\')
+                out << '\\';
+
+            out << c;
+        }
+    }
+
+    std::chrono::steady_clock::time_point _epoch;
+    std::vector<event> _events;
+    std::atomic<uint32_t> _threads{ 0 };
+    mutable std::mutex _lock;
+};
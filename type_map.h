@@ -0,0 +1,368 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct mapped_type {
+    std::string_view abi_name;
+    std::string_view mapped_namespace;
+    std::string_view mapped_name;
+    bool requires_marshaling;
+    bool has_custom_members_output;
+};
+
+/// A WinRT type that doesn't project as itself
+struct type_mapping {
+    std::string_view type_namespace;
+    mapped_type type;
+
+    // the TypeScript type it becomes where types are fully projected, empty when it keeps its own name
+    std::string_view projected_name{};
+};
+
+// Make sure to keep this table consistent with the registrations in WinRT.Runtime/Projections.cs
+// NOTE: Must keep namespaces sorted, and abi type names sorted within them, a static_assert checks it
+constexpr type_mapping builtin_type_mappings[] = {
+    { "Microsoft.UI.Xaml", { "CornerRadius", "Microsoft.UI.Xaml", "CornerRadius" } },
+    { "Microsoft.UI.Xaml", { "CornerRadiusHelper" } },
+    { "Microsoft.UI.Xaml", { "Duration", "Microsoft.UI.Xaml", "Duration" } },
+    { "Microsoft.UI.Xaml", { "DurationHelper" } },
+    { "Microsoft.UI.Xaml", { "DurationType", "Microsoft.UI.Xaml", "DurationType" } },
+    { "Microsoft.UI.Xaml", { "GridLength", "Microsoft.UI.Xaml", "GridLength" } },
+    { "Microsoft.UI.Xaml", { "GridLengthHelper" } },
+    { "Microsoft.UI.Xaml", { "GridUnitType", "Microsoft.UI.Xaml", "GridUnitType" } },
+    { "Microsoft.UI.Xaml", { "ICornerRadiusHelper" } },
+    { "Microsoft.UI.Xaml", { "ICornerRadiusHelperStatics" } },
+    { "Microsoft.UI.Xaml", { "IDurationHelper" } },
+    { "Microsoft.UI.Xaml", { "IDurationHelperStatics" } },
+    { "Microsoft.UI.Xaml", { "IGridLengthHelper" } },
+    { "Microsoft.UI.Xaml", { "IGridLengthHelperStatics" } },
+    { "Microsoft.UI.Xaml", { "IThicknessHelper" } },
+    { "Microsoft.UI.Xaml", { "IThicknessHelperStatics" } },
+    { "Microsoft.UI.Xaml", { "IXamlServiceProvider", "System", "IServiceProvider" } },
+    { "Microsoft.UI.Xaml", { "Thickness", "Microsoft.UI.Xaml", "Thickness" } },
+    { "Microsoft.UI.Xaml", { "ThicknessHelper" } },
+    { "Microsoft.UI.Xaml.Controls.Primitives", { "GeneratorPosition", "Microsoft.UI.Xaml.Controls.Primitives", "GeneratorPosition" } },
+    { "Microsoft.UI.Xaml.Controls.Primitives", { "GeneratorPositionHelper" } },
+    { "Microsoft.UI.Xaml.Controls.Primitives", { "IGeneratorPositionHelper" } },
+    { "Microsoft.UI.Xaml.Controls.Primitives", { "IGeneratorPositionHelperStatics" } },
+    { "Microsoft.UI.Xaml.Data", { "DataErrorsChangedEventArgs", "System.ComponentModel", "DataErrorsChangedEventArgs" } },
+    { "Microsoft.UI.Xaml.Data", { "INotifyDataErrorInfo", "System.ComponentModel", "INotifyDataErrorInfo", true, true } },
+    { "Microsoft.UI.Xaml.Data", { "INotifyPropertyChanged", "System.ComponentModel", "INotifyPropertyChanged" } },
+    { "Microsoft.UI.Xaml.Data", { "PropertyChangedEventArgs", "System.ComponentModel", "PropertyChangedEventArgs" } },
+    { "Microsoft.UI.Xaml.Data", { "PropertyChangedEventHandler", "System.ComponentModel", "PropertyChangedEventHandler" } },
+    { "Microsoft.UI.Xaml.Input", { "ICommand", "System.Windows.Input", "ICommand", true } },
+    { "Microsoft.UI.Xaml.Interop", { "IBindableIterable", "System.Collections", "IEnumerable", true } },
+    { "Microsoft.UI.Xaml.Interop", { "IBindableVector", "System.Collections", "IList", true } },
+    { "Microsoft.UI.Xaml.Interop", { "INotifyCollectionChanged", "System.Collections.Specialized", "INotifyCollectionChanged", true } },
+    { "Microsoft.UI.Xaml.Interop", { "NotifyCollectionChangedAction", "System.Collections.Specialized", "NotifyCollectionChangedAction" } },
+    { "Microsoft.UI.Xaml.Interop", { "NotifyCollectionChangedEventArgs", "System.Collections.Specialized", "NotifyCollectionChangedEventArgs", true } },
+    { "Microsoft.UI.Xaml.Interop", { "NotifyCollectionChangedEventHandler", "System.Collections.Specialized", "NotifyCollectionChangedEventHandler", true } },
+    { "Microsoft.UI.Xaml.Media", { "IMatrixHelper" } },
+    { "Microsoft.UI.Xaml.Media", { "IMatrixHelperStatics" } },
+    { "Microsoft.UI.Xaml.Media", { "Matrix", "Microsoft.UI.Xaml.Media", "Matrix" } },
+    { "Microsoft.UI.Xaml.Media", { "MatrixHelper" } },
+    { "Microsoft.UI.Xaml.Media.Animation", { "IKeyTimeHelper" } },
+    { "Microsoft.UI.Xaml.Media.Animation", { "IKeyTimeHelperStatics" } },
+    { "Microsoft.UI.Xaml.Media.Animation", { "IRepeatBehaviorHelper" } },
+    { "Microsoft.UI.Xaml.Media.Animation", { "IRepeatBehaviorHelperStatics" } },
+    { "Microsoft.UI.Xaml.Media.Animation", { "KeyTime", "Microsoft.UI.Xaml.Media.Animation", "KeyTime" } },
+    { "Microsoft.UI.Xaml.Media.Animation", { "KeyTimeHelper" } },
+    { "Microsoft.UI.Xaml.Media.Animation", { "RepeatBehavior", "Microsoft.UI.Xaml.Media.Animation", "RepeatBehavior" } },
+    { "Microsoft.UI.Xaml.Media.Animation", { "RepeatBehaviorHelper" } },
+    { "Microsoft.UI.Xaml.Media.Animation", { "RepeatBehaviorType", "Microsoft.UI.Xaml.Media.Animation", "RepeatBehaviorType" } },
+    { "Microsoft.UI.Xaml.Media.Media3D", { "IMatrix3DHelper" } },
+    { "Microsoft.UI.Xaml.Media.Media3D", { "IMatrix3DHelperStatics" } },
+    { "Microsoft.UI.Xaml.Media.Media3D", { "Matrix3D", "Microsoft.UI.Xaml.Media.Media3D", "Matrix3D" } },
+    { "Microsoft.UI.Xaml.Media.Media3D", { "Matrix3DHelper" } },
+    { "Windows.Foundation", { "DateTime", "System", "DateTimeOffset", true, false }, "Date" },
+    { "Windows.Foundation", { "EventHandler`1", "System", "EventHandler", false } },
+    { "Windows.Foundation", { "EventRegistrationToken", "WinRT", "EventRegistrationToken", false } },
+    { "Windows.Foundation", { "HResult", "System", "Exception", true, false }, "number" },
+    { "Windows.Foundation", { "IClosable", "System", "IDisposable", true, true } },
+    { "Windows.Foundation", { "IPropertyValue", "Windows.Foundation", "IPropertyValue", true } },
+    { "Windows.Foundation", { "IReferenceArray`1", "Windows.Foundation", "IReferenceArray", true } },
+    { "Windows.Foundation", { "IReference`1", "System", "Nullable", true } },
+    { "Windows.Foundation", { "Point", "Windows.Foundation", "Point" } },
+    { "Windows.Foundation", { "Rect", "Windows.Foundation", "Rect" } },
+    { "Windows.Foundation", { "Size", "Windows.Foundation", "Size" } },
+    { "Windows.Foundation", { "TimeSpan", "System", "TimeSpan", true, false }, "number" },
+    { "Windows.Foundation", { "Uri", "System", "Uri", true } },
+    { "Windows.Foundation.Collections", { "IIterable`1", "System.Collections.Generic", "IEnumerable`1", true, true } },
+    { "Windows.Foundation.Collections", { "IIterator`1", "System.Collections.Generic", "IEnumerator`1", true, true } },
+    { "Windows.Foundation.Collections", { "IKeyValuePair`2", "System.Collections.Generic", "KeyValuePair`2", true } },
+    { "Windows.Foundation.Collections", { "IMapView`2", "System.Collections.Generic", "IReadOnlyDictionary`2", true, true } },
+    { "Windows.Foundation.Collections", { "IMap`2", "System.Collections.Generic", "IDictionary`2", true, true } },
+    { "Windows.Foundation.Collections", { "IVectorView`1", "System.Collections.Generic", "IReadOnlyList`1", true, true } },
+    { "Windows.Foundation.Collections", { "IVector`1", "System.Collections.Generic", "IList`1", true, true } },
+    { "Windows.Foundation.Metadata", { "AttributeTargets", "System", "AttributeTargets" } },
+    { "Windows.Foundation.Metadata", { "AttributeUsageAttribute", "System", "AttributeUsageAttribute" } },
+    { "Windows.Foundation.Numerics", { "Matrix3x2", "System.Numerics", "Matrix3x2" } },
+    { "Windows.Foundation.Numerics", { "Matrix4x4", "System.Numerics", "Matrix4x4" } },
+    { "Windows.Foundation.Numerics", { "Plane", "System.Numerics", "Plane" } },
+    { "Windows.Foundation.Numerics", { "Quaternion", "System.Numerics", "Quaternion" } },
+    { "Windows.Foundation.Numerics", { "Vector2", "System.Numerics", "Vector2" } },
+    { "Windows.Foundation.Numerics", { "Vector3", "System.Numerics", "Vector3" } },
+    { "Windows.Foundation.Numerics", { "Vector4", "System.Numerics", "Vector4" } },
+    { "Windows.UI", { "Color", "Windows.UI", "Color" } },
+    { "Windows.UI", { "ColorHelper" } },
+    { "Windows.UI", { "IColorHelper" } },
+    { "Windows.UI", { "IColorHelperStatics" } },
+    { "Windows.UI", { "IColorHelperStatics2" } },
+    // Temporary, until WinUI provides TypeName
+    { "Windows.UI.Xaml.Interop", { "TypeKind", "Windows.UI.Xaml.Interop", "TypeKind", true } },
+    { "Windows.UI.Xaml.Interop", { "TypeName", "System", "Type", true } },
+};
+
+namespace type_map_impl {
+    // FNV-1a of the full name, computed once per key
+    constexpr uint64_t hash(std::string_view type_namespace, std::string_view type_name) {
+        uint64_t h = 14695981039346656037ull;
+        auto add = [&h](char c) { h = (h ^ static_cast<uint8_t>(c)) * 1099511628211ull; };
+        for (auto c : type_namespace) {
+            add(c);
+        }
+
+        add('.');
+        for (auto c : type_name) {
+            add(c);
+        }
+
+        return h;
+    }
+
+    constexpr size_t slot(uint64_t hash, uint32_t seed, size_t mask) {
+        return static_cast<size_t>(((hash ^ seed) * 0x9e3779b97f4a7c15ull) >> 40) & mask;
+    }
+
+    // the first seed that sends every hash to a slot of its own, or 0 when none of the first `attempts` does.
+    // `marks` starts zeroed and remembers the seed that last took each slot, so it never has to be cleared
+    template <typename Hashes, typename Marks>
+    constexpr uint32_t find_seed(Hashes const &hashes, size_t count, Marks &marks, size_t mask, uint32_t attempts) {
+        for (uint32_t seed = 1; seed <= attempts; seed++) {
+            size_t i = 0;
+            for (; i < count; i++) {
+                auto &mark = marks[slot(hashes[i], seed, mask)];
+                if (mark == seed)
+                    break;
+
+                mark = seed;
+            }
+
+            if (i == count)
+                return seed;
+        }
+
+        return 0;
+    }
+
+    // strictly increasing, so there are no duplicates for the hash to trip over either
+    template <size_t N>
+    constexpr bool is_sorted(type_mapping const (&mappings)[N]) {
+        for (size_t i = 1; i < N; i++) {
+            auto &a = mappings[i - 1];
+            auto &b = mappings[i];
+            if (b.type_namespace < a.type_namespace || (b.type_namespace == a.type_namespace && !(a.type.abi_name < b.type.abi_name)))
+                return false;
+        }
+
+        return true;
+    }
+
+    template <size_t Slots>
+    struct index {
+        uint32_t seed = 0;
+        std::array<uint16_t, Slots> slots{}; // mapping + 1, 0 for an empty slot
+    };
+
+    template <size_t Slots, size_t N>
+    constexpr index<Slots> build(type_mapping const (&mappings)[N]) {
+        static_assert((Slots & (Slots - 1)) == 0 && N < Slots);
+
+        std::array<uint64_t, N> hashes{};
+        for (size_t i = 0; i < N; i++) {
+            hashes[i] = hash(mappings[i].type_namespace, mappings[i].type.abi_name);
+        }
+
+        std::array<uint32_t, Slots> marks{};
+        index<Slots> result{};
+        result.seed = find_seed(hashes, N, marks, Slots - 1, 1u << 12);
+        for (size_t i = 0; i < N; i++) {
+            result.slots[slot(hashes[i], result.seed, Slots - 1)] = static_cast<uint16_t>(i + 1);
+        }
+
+        return result;
+    }
+} // namespace type_map_impl
+
+static_assert(type_map_impl::is_sorted(builtin_type_mappings), "builtin_type_mappings must be sorted by namespace, then by abi name");
+
+// sixteen slots per mapping, so a seed that leaves no collisions turns up within a few tries
+constexpr auto builtin_type_map_index = type_map_impl::build<2048>(builtin_type_mappings);
+static_assert(builtin_type_map_index.seed != 0, "no seed gives every builtin mapping a slot of its own, make the index bigger");
+
+/// Looks up how a type maps, in one probe of a perfect hash.
+///
+/// The builtin mappings are hashed at compile time. Mappings loaded from a file (--type-map) are
+/// added on top of them and the lot is hashed again the same way, once, when the file is read.
+class type_map {
+public:
+    /// Just the builtin mappings
+    type_map() = default;
+
+    /// The builtin mappings with the ones in `path` over them. Each line maps a type to the
+    /// TypeScript type it projects as, like `Windows.Storage.Streams.IBuffer = ArrayBuffer`, and
+    /// '#' starts a comment.
+    explicit type_map(std::filesystem::path const &path) {
+        std::ifstream in{ path, std::fstream::in | std::fstream::binary };
+        if (!in)
+            throw std::runtime_error("can't read type map " + path.string());
+
+        // the mappings point into the text, which isn't touched again
+        std::stringstream text;
+        text << in.rdbuf();
+        _text = std::make_unique<std::string const>(text.str());
+
+        _mappings.assign(std::begin(builtin_type_mappings), std::end(builtin_type_mappings));
+        parse(path.string());
+        build();
+    }
+
+    type_map(type_map const &) = delete;
+    type_map &operator=(type_map const &) = delete;
+
+    type_mapping const *find(std::string_view type_namespace, std::string_view type_name) const {
+        auto slot = _slots[type_map_impl::slot(type_map_impl::hash(type_namespace, type_name), _seed, _mask)];
+        if (slot == 0)
+            return nullptr;
+
+        auto &mapping = _entries[slot - 1];
+        if (mapping.type.abi_name != type_name || mapping.type_namespace != type_namespace)
+            return nullptr;
+
+        return &mapping;
+    }
+
+    /// The mappings read from the file, as they go into the manifest options
+    std::string to_string() const {
+        std::string s;
+        for (auto &&[name, projected] : _overrides) {
+            s += ",map=";
+            s += name;
+            s += "=";
+            s += projected;
+        }
+
+        return s;
+    }
+
+    /// The map lookups go through, the builtin one until another is installed
+    static type_map const &current() {
+        return *active();
+    }
+
+    /// Makes `map` the current one, only while nothing is looking types up
+    static void install(std::shared_ptr<type_map const> map) {
+        active() = std::move(map);
+    }
+
+private:
+    static std::shared_ptr<type_map const> &active() {
+        static std::shared_ptr<type_map const> map = std::make_shared<type_map const>();
+        return map;
+    }
+
+    static std::string_view trim(std::string_view s) {
+        auto first = s.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos)
+            return {};
+
+        return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+    }
+
+    void parse(std::string const &file) {
+        std::string_view text{ *_text };
+        size_t number = 0;
+        while (!text.empty()) {
+            number++;
+            auto end = text.find('\n');
+            auto line = text.substr(0, end);
+            text = end == std::string_view::npos ? std::string_view{} : text.substr(end + 1);
+
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty())
+                continue;
+
+            auto equals = line.find('=');
+            auto name = trim(line.substr(0, equals));
+            auto dot = name.rfind('.');
+            auto projected = equals == std::string_view::npos ? std::string_view{} : trim(line.substr(equals + 1));
+            if (dot == std::string_view::npos || dot == 0 || dot + 1 == name.size() || projected.empty())
+                throw std::invalid_argument(file + "(" + std::to_string(number) + "): expected 'Namespace.Type = TypeScriptType'");
+
+            auto type_namespace = name.substr(0, dot);
+            auto type_name = name.substr(dot + 1);
+            auto it = std::find_if(_mappings.begin(), _mappings.end(), [&](auto &&m) { return m.type_namespace == type_namespace && m.type.abi_name == type_name; });
+            if (it == _mappings.end())
+                it = _mappings.insert(_mappings.end(), type_mapping{ type_namespace, { type_name } });
+
+            it->projected_name = projected;
+            _overrides.emplace_back(name, projected);
+        }
+    }
+
+    void build() {
+        if (_mappings.size() >= UINT16_MAX)
+            throw std::invalid_argument("too many type mappings");
+
+        std::vector<uint64_t> hashes;
+        for (auto &&mapping : _mappings) {
+            hashes.push_back(type_map_impl::hash(mapping.type_namespace, mapping.type.abi_name));
+        }
+
+        // as big as the builtin index to begin with, doubled whenever a few hundred seeds all collide
+        size_t size = builtin_type_map_index.slots.size();
+        while (size < _mappings.size() * 16) {
+            size *= 2;
+        }
+
+        while (true) {
+            std::vector<uint32_t> marks(size);
+            _seed = type_map_impl::find_seed(hashes, hashes.size(), marks, size - 1, 256);
+            if (_seed != 0)
+                break;
+
+            size *= 2;
+        }
+
+        _mask = size - 1;
+        _own_slots.assign(size, 0);
+        for (size_t i = 0; i < hashes.size(); i++) {
+            _own_slots[type_map_impl::slot(hashes[i], _seed, _mask)] = static_cast<uint16_t>(i + 1);
+        }
+
+        _entries = _mappings.data();
+        _slots = _own_slots.data();
+    }
+
+    // the builtin index until a file is loaded
+    type_mapping const *_entries = builtin_type_mappings;
+    uint16_t const *_slots = builtin_type_map_index.slots.data();
+    size_t _mask = builtin_type_map_index.slots.size() - 1;
+    uint32_t _seed = builtin_type_map_index.seed;
+
+    std::unique_ptr<std::string const> _text;
+    std::vector<type_mapping> _mappings;
+    std::vector<uint16_t> _own_slots;
+    std::vector<std::pair<std::string_view, std::string_view>> _overrides;
+};
@@ -0,0 +1,184 @@
+#pragma once
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <system_error>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/// Waits for winmd files to change, for --watch.
+///
+/// The directories holding the files are watched rather than the files themselves, since a build
+/// usually replaces a winmd instead of writing into it. A change only counts once the directory has
+/// been quiet for a moment, so a file is never picked up half written.
+class file_watcher {
+public:
+    /// Watches `inputs`, each a winmd file or a directory of them
+    explicit file_watcher(std::vector<std::string> const& inputs) {
+        for (auto&& input : inputs) {
+            auto path = std::filesystem::absolute(input).lexically_normal();
+            if (std::filesystem::is_directory(path)) {
+                _directories.insert(path);
+                _roots.push_back(path);
+            }
+            else {
+                _directories.insert(path.parent_path());
+                _files.push_back(path);
+            }
+        }
+
+        _state = snapshot();
+        open();
+    }
+
+    ~file_watcher() {
+        close();
+    }
+
+    file_watcher(file_watcher const&) = delete;
+    file_watcher& operator=(file_watcher const&) = delete;
+
+    /// Blocks until a watched winmd is added, removed or rewritten, and returns the ones that did
+    std::vector<std::filesystem::path> wait() {
+        while (true) {
+            wait_for_event();
+
+            // let the writer finish before looking at what it did
+            while (wait_for_event(settle_time)) {
+            }
+
+            auto state = snapshot();
+            std::vector<std::filesystem::path> changed;
+            for (auto&& [path, stamp] : state) {
+                auto it = _state.find(path);
+                if (it == _state.end() || it->second != stamp)
+                    changed.push_back(path);
+            }
+
+            for (auto&& [path, stamp] : _state) {
+                if (state.find(path) == state.end())
+                    changed.push_back(path);
+            }
+
+            _state = std::move(state);
+            if (!changed.empty())
+                return changed;
+        }
+    }
+
+private:
+    static constexpr std::chrono::milliseconds settle_time{ 250 };
+
+    // what tells two versions of a file apart without reading it
+    struct stamp {
+        std::filesystem::file_time_type time;
+        uintmax_t size = 0;
+
+        bool operator!=(stamp const& other) const {
+            return time != other.time || size != other.size;
+        }
+    };
+
+    std::map<std::filesystem::path, stamp> snapshot() const {
+        std::map<std::filesystem::path, stamp> state;
+        auto add = [&](std::filesystem::path const& path) {
+            std::error_code ec;
+            stamp s{ std::filesystem::last_write_time(path, ec), std::filesystem::file_size(path, ec) };
+            if (!ec)
+                state[path] = s;
+        };
+
+        for (auto&& file : _files) {
+            add(file);
+        }
+
+        for (auto&& root : _roots) {
+            std::error_code ec;
+            for (auto&& entry : std::filesystem::directory_iterator(root, ec)) {
+                if (entry.path().extension() == ".winmd")
+                    add(entry.path());
+            }
+        }
+
+        return state;
+    }
+
+#ifdef _WIN32
+    void open() {
+        for (auto&& directory : _directories) {
+            auto handle = FindFirstChangeNotificationW(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE);
+            if (handle == INVALID_HANDLE_VALUE)
+                throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "can't watch " + directory.string());
+
+            _handles.push_back(handle);
+        }
+    }
+
+    void close() {
+        for (auto&& handle : _handles) {
+            FindCloseChangeNotification(handle);
+        }
+    }
+
+    bool wait_for_event(std::chrono::milliseconds timeout = std::chrono::milliseconds(INFINITE)) {
+        auto result = WaitForMultipleObjects(static_cast<DWORD>(_handles.size()), _handles.data(), FALSE, static_cast<DWORD>(timeout.count()));
+        if (result == WAIT_TIMEOUT)
+            return false;
+
+        if (result >= WAIT_OBJECT_0 + _handles.size())
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "waiting for changes failed");
+
+        FindNextChangeNotification(_handles[result - WAIT_OBJECT_0]);
+        return true;
+    }
+
+    std::vector<HANDLE> _handles;
+#else
+    void open() {
+        _fd = inotify_init1(IN_CLOEXEC);
+        if (_fd < 0)
+            throw std::system_error(errno, std::generic_category(), "inotify_init1");
+
+        for (auto&& directory : _directories) {
+            if (inotify_add_watch(_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE) < 0)
+                throw std::system_error(errno, std::generic_category(), "can't watch " + directory.string());
+        }
+    }
+
+    void close() {
+        if (_fd >= 0)
+            ::close(_fd);
+    }
+
+    bool wait_for_event(std::chrono::milliseconds timeout = std::chrono::milliseconds(-1)) {
+        pollfd fd{ _fd, POLLIN, 0 };
+        auto result = poll(&fd, 1, static_cast<int>(timeout.count()));
+        if (result < 0 && errno != EINTR)
+            throw std::system_error(errno, std::generic_category(), "waiting for changes failed");
+
+        if (result <= 0)
+            return false;
+
+        // the events themselves don't matter, the snapshot says what changed
+        alignas(inotify_event) char buffer[4096];
+        return read(_fd, buffer, sizeof(buffer)) > 0;
+    }
+
+    int _fd = -1;
+#endif
+
+    std::set<std::filesystem::path> _directories;
+    std::vector<std::filesystem::path> _files;
+    std::vector<std::filesystem::path> _roots; // directories given as inputs, every winmd in them is watched
+    std::map<std::filesystem::path, stamp> _state;
+};
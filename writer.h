@@ -5,41 +5,167 @@
 #include <string>
 #include <sstream>
 #include <filesystem>
+#include <thread>
+#include <optional>
+#include <functional>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
 #include <winmd_reader.h>
+#include "platform.h"
+#ifdef _WIN32
 #include <comdef.h>
+#include "interop/interop.h"
+#endif
 #include "helpers.h"
+#include "settings.h"
+#include "manifest.h"
+#include "output_sink.h"
+#include "identifiers.h"
+#include "namespace_trie.h"
+#include "namespace_filter.h"
+#include "interface_map.h"
+#include "stats.h"
+#include "trace.h"
 
 using namespace winmd::reader;
 
+// what a namespace module is called in its namespace's directory, so importing the directory finds it
+constexpr std::string_view namespace_module_name = "index";
+
+/// An input assembly and the output directory its namespaces are projected below
+struct projection_root {
+    database const* db;
+    std::string_view name;
+    std::filesystem::path path;
+    std::shared_ptr<namespace_trie const> namespaces;
+};
+
+/// Every assembly projected by a run, and which of them projects each namespace
+struct projection_set {
+    std::vector<projection_root> roots;
+    std::unordered_map<std::string_view, size_t> owners;
+    std::unordered_set<std::string_view> excluded; // namespaces of the inputs left out by the namespace filter
+
+    /// The root projecting `ns`, or nothing when no input defines it
+    projection_root const* owner(std::string_view ns) const {
+        auto it = owners.find(ns);
+        return it != owners.end() ? &roots[it->second] : nullptr;
+    }
+};
+
 class writer {
 private:
-    std::set<std::string> _banned_identifiers{ "function", "arguments", "package" };
-    std::map<std::string_view, std::map<std::string_view, std::string_view>> _namespace_type_map{
-        { "Windows.Foundation", {
-                                    { "DateTime", "Date" },
-                                    { "TimeSpan", "number" },
-                                    { "HResult", "number" },
-                                } }
-    };
-
 public:
-    writer(std::vector<std::string> assemblies, std::filesystem::path& path) : _cache(assemblies), _path(path), _basePath(path), _out() {
-        auto&& db = _cache.databases().front(); // grab the first database
-        auto&& assembly = db.Assembly.begin();  // grab the first assembly
-        auto pathBits = tokenise_string(std::string(assembly.Name()), ".");
-        for (auto& bit : pathBits) {
-            _basePath = _basePath.append(bit);
-            _path = _path.append(bit);
+    writer(settings const& settings, std::filesystem::path const& path) : _stats(std::make_shared<run_stats>()), _cache(load_cache(*_stats, settings)), _path(path), _basePath(path), _out() {
+        auto discover = _stats->phase("discover namespaces");
+        auto projections = std::make_shared<projection_set>();
+        std::set<std::string_view> duplicates;
+        _filter = namespace_filter{ settings.include, settings.exclude };
+        type_map::install(settings.type_map.empty() ? std::make_shared<type_map const>() : std::make_shared<type_map const>(settings.type_map));
+        for (auto&& db : _cache->databases()) {
+            if (!is_input(db, settings))
+                continue; // only there to resolve references
+
+            auto&& assembly = db.Assembly.begin(); // grab the first assembly
+            auto& root = projections->roots.emplace_back();
+            root.db = &db;
+            root.name = assembly.Name();
+            root.path = path;
+            for_each_segment(root.name, [&](std::string_view bit) { root.path.append(bit); });
+
+            // a namespace spread over several inputs is projected once, by the first of them
+            for (auto&& type : db.TypeDef) {
+                if (!type.Flags().WindowsRuntime())
+                    continue;
+
+                // filtered out namespaces are never visited again, references to their types are stubbed
+                if (!_filter.empty() && (projections->excluded.count(type.TypeNamespace()) || !_filter.matches(type.TypeNamespace()))) {
+                    projections->excluded.insert(type.TypeNamespace());
+                    continue;
+                }
+
+                auto [owner, inserted] = projections->owners.emplace(type.TypeNamespace(), projections->roots.size() - 1);
+                if (!inserted && owner->second != projections->roots.size() - 1 && duplicates.emplace(type.TypeNamespace()).second)
+                    std::cout << "Namespace " << type.TypeNamespace() << " is projected by " << projections->roots[owner->second].name << ", not by " << root.name << std::endl;
+            }
         }
 
-        for (auto&& type : db.TypeDef) {
-            if (!type.Flags().WindowsRuntime()) {
-                continue;
+        if (projections->roots.empty())
+            throw_invalid("none of the winmd files given is an input");
+
+        for (size_t i = 0; i < projections->roots.size(); i++) {
+            auto& root = projections->roots[i];
+            auto namespaces = std::make_shared<namespace_trie>(root.path);
+            for (auto&& [ns_name, members] : _cache->namespaces()) {
+                namespaces->insert(ns_name).members = &members;
             }
 
-            // store all the namespaces in it (these are the ones we're gonna process)
-            _namespaces.emplace(type.TypeNamespace());
+            // synthesised after the fact, but imported like everything else
+            namespaces->insert("Windows.Foundation.Interop");
+
+            // mark all the namespaces it owns (these are the ones we're gonna process)
+            for (auto&& [ns_name, owner] : projections->owners) {
+                if (owner == i)
+                    namespaces->mark_projected(namespaces->insert(ns_name));
+            }
+
+            root.namespaces = namespaces;
+        }
+
+        _projections = projections;
+        select(_projections->roots.front());
+        find_stale_roots(settings);
+        discover.end();
+
+        if (!settings.trace.empty()) {
+            _trace = std::make_shared<trace_log>();
+            _trace_path = settings.trace;
         }
+
+        _layout = settings.layout;
+        _lazy_index = settings.lazy_index;
+        _declarations = settings.declarations_only;
+        _jobs = settings.jobs != 0 ? settings.jobs : std::max<uint32_t>(1u, std::thread::hardware_concurrency());
+
+        // every file of a run carries the same timestamp, so the output doesn't depend on how it was scheduled
+        _timestamp = format_time(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+
+        {
+            auto scan = _stats->phase("scan output");
+
+            // the manifest sits next to the output directory, and is written even when --force ignores the old one
+            _manifest = std::make_shared<manifest>(std::filesystem::path(path).concat(".manifest"), path, options());
+            // the roots that aren't projected again need their entries carried over
+            if (!settings.incremental || !_manifest->load())
+                _stale_roots.clear();
+
+            _sink = std::make_shared<output_sink>(path);
+        }
+
+        auto index = _stats->phase("index metadata");
+
+        // names and attributes of databases that haven't changed since the last run are kept from
+        // it, or read back from its snapshots
+        auto unsaved = load_tables(std::filesystem::path(path).concat(".snapshots"), settings.snapshots);
+
+        // normalise every member name, decode every attribute, resolve every interface and number
+        // every vtable slot up front, emission only reads them back
+        database_index<identifier_table>::build(*_cache, _jobs);
+        database_index<attribute_table>::build(*_cache, _jobs);
+        save_snapshots(unsaved);
+
+        // only types that are projected need their interfaces, references are resolved if anything asks
+        std::vector<database const*> inputs;
+        for (auto&& root : _projections->roots) {
+            if (stale(root))
+                inputs.push_back(root.db);
+        }
+
+        database_index<interface_table>::build(inputs, _jobs, _filter);
+#ifdef _WIN32
+        database_index<interop::vtable_slot_table>::build(*_cache, _jobs);
+#endif
     }
 
 #pragma region generic stuff
@@ -56,16 +182,19 @@ public:
         return _generic_args.get(index);
     }
 
-    auto get_generic_arg(uint32_t index) {
+    type_semantics const& get_generic_arg(uint32_t index) {
         return get_generic_arg_scope(index).first;
     }
 #pragma endregion
 
     bool should_project_type(TypeDef type_def) {
+        if (!_projections->excluded.empty() && _projections->excluded.count(type_def.TypeNamespace()))
+            return false;
+
         if (is_exclusive_to(type_def) && !_include_exclusive)
             return false;
 
-        if (has_attribute(type_def, "Windows.Foundation.Metadata", "WebHostHiddenAttribute") && !_allow_webhosthidden)
+        if (has_attribute(type_def, known_attribute::webhost_hidden) && !_allow_webhosthidden)
             return false;
 
         //if (type_def.Flags().Visibility() == TypeVisibility::NotPublic)
@@ -75,30 +204,127 @@ public:
     }
 
     void write() {
-        write_files();
-        write_module();
+        for (auto&& root : _projections->roots) {
+            if (!stale(root)) {
+                // nothing it's projected from changed, its files and manifest entries stay as they are
+                auto kept = _manifest->carry_over([&](std::string const& type_name) {
+                    return _projections->owner(std::string_view(type_name).substr(0, type_name.rfind('.'))) == &root;
+                });
+
+                _stats->count(run_stats::counter::unchanged_types, kept);
+                continue;
+            }
+
+            select(root);
+            write_root();
+        }
+
+        {
+            auto phase = _stats->phase("file I/O");
+            auto span = trace("phase", "file I/O");
+            auto written = _sink->commit();
+            _manifest->save();
+
+            _stats->count(run_stats::counter::files_written, written.files);
+            _stats->count(run_stats::counter::files_created, written.created);
+            _stats->count(run_stats::counter::bytes_written, written.bytes);
+        }
+
+        if (_trace)
+            _trace->save(_trace_path);
     }
 
-    void write_module() {
-        auto&& assembly = _cache.databases().front().Assembly.begin(); // grab the first assembly
+    // projects the namespaces of the selected root and its index.ts
+    void write_root() {
+        // the phases of every root are reported separately once there's more than one
+        auto phase_name = [&](std::string_view name) {
+            return _projections->roots.size() > 1 ? std::string(name) + " " + std::string(_root->name) : std::string(name);
+        };
 
-        _stack.clear();
-        _path = _basePath;
+        if (_layout == output_layout::per_namespace)
+            _split = split_cycles();
 
-        if (!std::filesystem::exists(_path))
-            std::filesystem::create_directories(_path);
+        // the bundle is a single file, it's either entirely up to date or written again from scratch
+        if (_layout == output_layout::bundle && bundle_unchanged())
+            return;
 
-        _path.append("index.ts");
-        _out.open(_path, std::fstream::out | std::fstream::trunc);
+        {
+            auto phase = _stats->phase(phase_name("project types"));
+            auto span = trace("phase", phase_name("project types"));
+            write_files();
+        }
+
+        {
+            auto phase = _stats->phase(phase_name("write_module"));
+            auto span = trace("phase", phase_name("write_module"));
+            if (_layout == output_layout::bundle)
+                write_bundle();
+            else
+                write_module();
+        }
+    }
+
+    /// Keeps the names and attributes of every database in memory, for the next writer of a --watch
+    /// session to adopt for each winmd that's still the same rather than building them again. The
+    /// reader can't swap one database of a cache for another, so the metadata itself is loaded again.
+    void retain_indexes() const {
+        auto& retained = retained_tables();
+        retained.clear();
+        for (auto&& [db, key] : _table_keys) {
+            snapshot_writer out;
+            database_index<identifier_table>::get(*db).save(out);
+            database_index<attribute_table>::get(*db).save(out);
+            retained[key] = std::make_shared<mapped_file const>(out.data());
+        }
+    }
+
+    /// Forgets everything derived from the metadata of earlier writers, call it before another
+    /// writer loads a fresh cache in the same process. What retain_indexes() kept is adopted again.
+    static void release_indexes() {
+        database_index<identifier_table>::clear();
+        database_index<attribute_table>::clear();
+        database_index<interface_table>::clear();
+#ifdef _WIN32
+        database_index<interop::vtable_slot_table>::clear();
+        iid_cache::clear();
+#endif
+        type_semantics_cache::clear();
+        instantiation_table::clear();
+    }
+
+    /// Timings and counts of everything done so far
+    run_stats const& stats() const {
+        return *_stats;
+    }
+
+    // the configuration that changes what gets emitted, a manifest written under different options is stale
+    std::string options() const {
+        std::stringstream s;
+        s << "decorators=" << _enable_decorators << ",shims=" << _generate_shims << ",exclusive=" << _include_exclusive << ",webhosthidden=" << _allow_webhosthidden << ",layout=" << static_cast<int>(_layout) << ",declarations=" << _declarations << _filter.to_string() << type_map::current().to_string();
+
+        // which input projects a namespace decides where its files go
+        for (auto&& root : _projections->roots) {
+            s << ",root=" << root.name;
+        }
+
+        return s.str();
+    }
+
+    void write_module() {
+        auto&& assembly = _root->db->Assembly.begin();
+
+        _current = &_namespaces->root();
+        _path = _basePath;
+        _path.append("index" + extension());
 
         write_header();
 
-        for (auto ns : _cache.namespaces()) {
-            std::string ns_name(ns.first);
-            if (_namespaces.find(ns_name) == _namespaces.end())
-                continue; // we're not processing types in this namespace
+        _namespaces->visit([&](namespace_node const& ns) {
+            if (!ns.projected || !ns.members)
+                return; // we're not processing types in this namespace
 
-            for (auto&& [n, type] : ns.second.types) {
+            std::string ns_name(ns.name);
+            for (auto&& [n, type] : ns.members->types) {
                 if (!should_project_type(type))
                     continue;
 
@@ -110,165 +336,670 @@ public:
                 std::string type_name = ns_name + "." + std::string(n);
                 std::string name_override = ns_name + "." + name;
                 std::replace(name_override.begin(), name_override.end(), '.', '_');
-                write_import(type_name, name + " as " + name_override);
+
+                // a type only import leaves nothing behind at runtime, the module is loaded on first use
+                if (_lazy_index && !_declarations)
+                    _out << "import type { " << name << " as " << name_override << " } from \"" << module_path(ns, n) << "\";" << std::endl;
+                else
+                    write_import(type_name, name + " as " + name_override);
             }
-        }
+        });
 
         _out << std::endl;
 
-        auto push = [this](std::string& ns) {
-            _out << whitespace(_stack.size());
-            write_namespace_decl(ns);
+        if (_lazy_index && !_declarations) {
+            _out << "declare function require(module: string): any;" << std::endl;
+            _out << std::endl;
+            _out << "// reads `name` from `module` the first time it's asked for, and keeps it from then on" << std::endl;
+            _out << "function defineLazy(target: object, name: string, module: string) {" << std::endl;
+            _out << "    Object.defineProperty(target, name, {" << std::endl;
+            _out << "        configurable: true," << std::endl;
+            _out << "        enumerable: true," << std::endl;
+            _out << "        get() {" << std::endl;
+            _out << "            const value = require(module)[name];" << std::endl;
+            _out << "            Object.defineProperty(target, name, { value, enumerable: true });" << std::endl;
+            _out << "            return value;" << std::endl;
+            _out << "        }," << std::endl;
+            _out << "    });" << std::endl;
+            _out << "}" << std::endl;
+            _out << std::endl;
+        }
 
-            _stack.push_back(ns);
-        };
+        write_module_namespaces(_namespaces->root());
 
-        auto pop = [this]() {
-            _stack.pop_back();
-            _out << whitespace(_stack.size()) << "}" << std::endl;
-        };
+        // a declaration file describes modules, it can't put anything on globalThis
+        if (!_declarations)
+            _out << "globalThis['" << assembly.Name() << "'] = " << assembly.Name() << ";" << std::endl;
+
+        _sink->stage(_path, _out.str());
+        _out.str("");
+    }
 
-        for (auto ns : _cache.namespaces()) {
-            std::string ns_name(ns.first);
-            if (_namespaces.find(ns_name) == _namespaces.end())
-                continue; // we're not processing types in this namespace
+    // re-exports the projected types below `parent` from nested namespace declarations. In a lazy
+    // index, classes and enums are declared only, and defined as getters that load their module
+    void write_module_namespaces(namespace_node const& parent) {
+        for (auto&& [segment, child] : parent.children) {
+            auto& ns = *child;
+            if (!ns.contains_projected)
+                continue;
 
-            auto ns_bits = tokenise_string(ns_name, "."); // split by .
-            while (_stack.size() > ns_bits.size())
-                pop();
+            _out << whitespace(ns.depth - 1);
+            write_namespace_decl(ns.segment);
+
+            if (ns.projected && ns.members) {
+                std::string ns_name(ns.name);
+                for (auto&& [n, type] : ns.members->types) {
+                    if (!should_project_type(type))
+                        continue;
+
+                    std::string name{ n };
+                    auto index = name.find('`');
+                    if (index != std::string::npos)
+                        name = name.substr(0, index);
+
+                    std::string name_override = ns_name + "." + name;
+                    std::replace(name_override.begin(), name_override.end(), '.', '_');
+
+                    std::string export_type = "type";
+                    auto category = get_category(type);
+                    if (category == category::class_type || category == category::enum_type)
+                        export_type = "const";
+
+                    auto guard{ _generic_args.push(type.GenericParam()) };
+                    auto generic_params = generic_type_params(type);
+                    // nothing can be assigned in a declaration file, an import alias carries both the value and the type
+                    if (_declarations && export_type == "const") {
+                        _out << whitespace(ns.depth) << "export import " << typedef_name(type, false) << " = " << name_override << ";" << std::endl;
+                        continue;
+                    }
 
-            for (int32_t i = min(ns_bits.size(), _stack.size()) - 1; i > 0; i--) {
-                auto bit = ns_bits[i];
-                if (!_stack.empty() && _stack.back() != bit)
-                    pop();
-                else
-                    break;
+                    if (_lazy_index && export_type == "const") {
+                        _out << whitespace(ns.depth) << "export declare const " << typedef_name(type, false) << ": typeof " << name_override << ";" << std::endl;
+                        _out << whitespace(ns.depth) << "defineLazy(" << ns.segment << ", \"" << name << "\", \"" << module_path(ns, n) << "\");" << std::endl;
+                        continue;
+                    }
+
+                    _out << whitespace(ns.depth) << "export " << export_type << " " << typedef_name(type, false) << generic_params << " = " << name_override << generic_params << ";" << std::endl;
+                }
             }
 
-            for (size_t i = _stack.size(); i < ns_bits.size(); i++) {
-                push(ns_bits[i]);
+            write_module_namespaces(ns);
+            _out << whitespace(ns.depth - 1) << "}" << std::endl;
+        }
+    }
+
+    // the whole projection in index.ts, each namespace's module in its own namespace block
+    void write_bundle() {
+        auto&& assembly = _root->db->Assembly.begin();
+
+        _current = &_namespaces->root();
+        _path = bundle_path();
+
+        write_header();
+
+        // ES imports can't go in a namespace block, whatever comes from outside the bundle is imported up here
+        std::set<std::string> external;
+        for (auto&& [ns, module] : _bundle) {
+            external.insert(module.external.begin(), module.external.end());
+        }
+
+        // types from another root's bundle are reached through the namespaces it exports, imported once per root
+        std::map<projection_root const*, std::vector<std::string const*>> other_bundles;
+        for (auto&& type_name : external) {
+            auto owner = _projections->owner(std::string_view(type_name).substr(0, type_name.rfind('.')));
+            if (owner && owner != _root && should_project_type(_cache->find_required(type_name)))
+                other_bundles[owner].push_back(&type_name);
+            else
+                write_import(type_name);
+        }
+
+        for (auto&& [owner, type_names] : other_bundles) {
+            std::string alias{ owner->name };
+            std::replace(alias.begin(), alias.end(), '.', '_');
+
+            auto path_str = (owner->path / "index").lexically_relative(_basePath).generic_string();
+            if (path_str.substr(0, 3) != "../")
+                path_str = "./" + path_str;
+
+            _out << "import * as " << alias << " from \"" << path_str << "\";" << std::endl;
+            for (auto&& type_name : type_names) {
+                auto separator = type_name->rfind('.');
+                auto name = type_name->substr(separator + 1);
+                name = name.substr(0, name.find('`'));
+                _out << "import " << name << " = " << alias << "." << type_name->substr(0, separator) << "." << name << ";" << std::endl;
             }
+        }
 
-            for (auto&& [n, type] : ns.second.types) {
-                if (!should_project_type(type))
-                    continue;
+        if (!external.empty())
+            _out << std::endl;
 
-                std::string name{ n };
-                auto index = name.find('`');
-                if (index != std::string::npos)
-                    name = name.substr(0, index);
+        write_bundle_types();
 
-                std::string name_override = ns_name + "." + name;
-                std::replace(name_override.begin(), name_override.end(), '.', '_');
+        if (!_declarations)
+            _out << "globalThis['" << assembly.Name() << "'] = " << assembly.Name() << ";" << std::endl;
+
+        _sink->stage(_path, _out.str());
+        _out.str("");
+        _bundle.clear();
+    }
+
+    // every type in the bundle, each class after the class it extends wherever that is. Namespace blocks
+    // and the import aliases in them run in order, so a namespace's block is opened again each time
+    // that order comes back to it
+    void write_bundle_types() {
+        using placed_type = std::pair<namespace_node const*, module_type const*>;
+        std::map<std::pair<database const*, uint32_t>, placed_type> types;
+        for (auto&& [ns, module] : _bundle) {
+            for (auto&& type : module.types)
+                types[{ &type.type.get_database(), type.type.index() }] = { ns, &type };
+        }
+
+        std::vector<placed_type> ordered;
+        std::set<std::pair<database const*, uint32_t>> placed;
+        _namespaces->visit([&](namespace_node const& ns) {
+            auto module = _bundle.find(&ns);
+            if (module == _bundle.end())
+                return;
+
+            for (auto&& type : module->second.types) {
+                std::vector<placed_type> chain;
+                for (std::optional<TypeDef> t = type.type; t; t = projected_base(*t)) {
+                    auto it = types.find({ &t->get_database(), t->index() });
+                    if (it == types.end() || !placed.insert(it->first).second)
+                        break;
+
+                    chain.push_back(it->second);
+                }
+
+                ordered.insert(ordered.end(), chain.rbegin(), chain.rend());
+            }
+        });
 
-                std::string export_type = "type";
-                auto category = get_category(type);
-                if (category == category::class_type || category == category::enum_type)
-                    export_type = "const";
+        for (size_t first = 0; first < ordered.size();) {
+            auto ns = ordered[first].first;
+            auto last = first;
+            std::set<std::string_view> imports;
+            for (; last < ordered.size() && ordered[last].first == ns; last++) {
+                // the same alias in scope for several of them is only written once
+                std::string_view text = ordered[last].second->imports;
+                while (!text.empty()) {
+                    auto end = text.find('\n');
+                    imports.insert(text.substr(0, end));
+                    if (end == std::string_view::npos)
+                        break;
+
+                    text.remove_prefix(end + 1);
+                }
+            }
+
+            write_namespace_decl(ns->name);
+            for (auto&& line : imports) {
+                _out << whitespace(1) << line << std::endl;
+            }
+
+            if (!imports.empty())
+                _out << std::endl;
+
+            for (auto n = first; n < last; n++) {
+                if (n != first)
+                    _out << std::endl;
 
-                auto guard{ _generic_args.push(type.GenericParam()) };
-                auto generic_params = generic_type_params(type);
-                _out << whitespace(_stack.size()) << "export " << export_type << " " << typedef_name(type, false) << generic_params << " = " << name_override << generic_params << ";" << std::endl;
+                write_indented(ordered[n].second->body, 1);
             }
+
+            _out << "}" << std::endl;
+            first = last;
         }
+    }
+
+    void write_indented(std::string_view text, size_t depth) {
+        while (!text.empty()) {
+            auto end = text.find('\n');
+            auto line = text.substr(0, end);
+            if (!line.empty())
+                _out << whitespace(depth) << line;
+
+            _out << std::endl;
+            if (end == std::string_view::npos)
+                break;
 
-        while (!_stack.empty()) {
-            pop();
+            text.remove_prefix(end + 1);
         }
-        _out << "globalThis['" << assembly.Name() << "'] = " << assembly.Name() << ";" << std::endl;
     }
 
     void write_files() {
-        _path = _basePath;
-        for (auto ns : _cache.namespaces()) {
-            std::string ns_name(ns.first);
-            if (_namespaces.find(ns_name) == _namespaces.end())
-                continue; // we're not processing types in this namespace
-
-            auto ns_bits = tokenise_string(ns_name, "."); // split by .
-            while (_stack.size() > ns_bits.size())
-                pop();
-
-            for (int32_t i = min(ns_bits.size(), _stack.size()) - 1; i > 0; i--) {
-                auto bit = ns_bits[i];
-                if (!_stack.empty() && _stack.back() != bit)
-                    pop();
-                else
-                    break;
+        std::vector<namespace_node const*> namespaces;
+        _namespaces->visit([&](namespace_node const& ns) {
+            if (ns.projected && ns.members)
+                namespaces.push_back(&ns);
+        });
+
+        // the bundle is put together from every namespace's module once they're all projected
+        std::vector<namespace_module> modules(_layout == output_layout::bundle ? namespaces.size() : 0);
+        auto write = [&](writer& w, size_t n) {
+            if (_layout == output_layout::bundle)
+                modules[n] = w.project_namespace(*namespaces[n], bundle_path());
+            else
+                w.write_namespace(*namespaces[n]);
+        };
+
+        size_t jobs = std::min<size_t>(_jobs, namespaces.size());
+        if (jobs <= 1) {
+            for (size_t n = 0; n < namespaces.size(); n++) {
+                write(*this, n);
             }
+        }
+        else {
+            write_parallel(namespaces.size(), jobs, write);
+        }
+
+        for (size_t n = 0; n < modules.size(); n++) {
+            _bundle[namespaces[n]] = std::move(modules[n]);
+        }
+    }
 
-            for (size_t i = _stack.size(); i < ns_bits.size(); i++) {
-                _path = _path.append(ns_bits[i]);
-                _stack.push_back(ns_bits[i]);
+    template <typename F>
+    void write_parallel(size_t count, size_t jobs, F&& write) {
+        // namespaces are handed out one at a time, each worker projects into its own context
+        std::atomic<size_t> next{ 0 };
+        std::vector<std::exception_ptr> errors(jobs);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < jobs; i++) {
+            threads.emplace_back([&, i]() {
+                // write_properties activates runtime classes, so every worker needs an apartment
+#ifdef _WIN32
+                winrt::init_apartment();
+#endif
+
+                try {
+                    writer worker{ *this, worker_t{} };
+                    for (size_t n = next++; n < count; n = next++) {
+                        write(worker, n);
+                    }
+                }
+                catch (...) {
+                    errors[i] = std::current_exception();
+                }
+
+#ifdef _WIN32
+                winrt::uninit_apartment();
+#endif
+            });
+        }
+
+        for (auto&& thread : threads) {
+            thread.join();
+        }
+
+        for (auto&& error : errors) {
+            if (error)
+                std::rethrow_exception(error);
+        }
+    }
+
+    void write_namespace(namespace_node const& ns) {
+        if (_layout == output_layout::per_type) {
+            write_type_files(ns);
+            return;
+        }
+
+        _current = &ns;
+        if (namespace_unchanged(ns))
+            return;
+
+        // the classes split out of a cycle between namespace modules get a module each, this one re-exports them
+        std::vector<TypeDef> split_types;
+        for (auto&& type : ordered_types(ns)) {
+            if (should_project_type(type) && split(type))
+                split_types.push_back(type);
+        }
+
+        for (auto&& type : split_types) {
+            auto type_name = std::string(type.TypeNamespace()) + "." + std::string(type.TypeName());
+            write_type_file(ns, type, type_name, type_fingerprint(type));
+        }
+
+        _current_module = namespace_module_name;
+        _path = _sink->resolve(ns.path / (std::string(namespace_module_name) + extension()));
+        auto module = project_namespace(ns, _path);
+
+        write_header();
+        _out << module.imports;
+        for (auto&& type : split_types) {
+            auto name = type.TypeName().substr(0, type.TypeName().find('`'));
+            _out << "export { " << name << " } from \"" << module_path(ns, type.TypeName()) << "\";" << std::endl;
+        }
+
+        if (!module.imports.empty() || !split_types.empty())
+            _out << std::endl;
+
+        _out << module.body;
+
+        _sink->stage(_path, _out.str());
+        _out.str("");
+    }
+
+    /// One type of a bundled namespace, with the aliases it needs in scope
+    struct module_type {
+        TypeDef type;
+        std::string imports;
+        std::string body;
+    };
+
+    /// The projection of every type in a namespace, for the layouts that don't give each type its own file
+    struct namespace_module {
+        std::string imports;
+        std::string body;
+        std::vector<module_type> types; // bundle only, placed one by one so bases come first
+        std::set<std::string> external; // bundle only, imported from outside the bundle at the top of the file
+    };
+
+    namespace_module project_namespace(namespace_node const& ns, std::filesystem::path const& file) {
+        auto span = trace("namespace", ns.name);
+        _current = &ns;
+
+        namespace_module module;
+        std::set<std::string> imported;
+        for (auto&& type : ordered_types(ns)) {
+            if (!should_project_type(type)) {
+                std::cout << "Skipping type " << type.TypeNamespace() << "." << type.TypeName() << std::endl;
+                _stats->count(run_stats::counter::skipped_types);
+                continue;
             }
 
-            if (!std::filesystem::is_directory(_path))
-                std::filesystem::create_directories(_path);
+            // written to a module of its own by write_namespace
+            if (split(type))
+                continue;
 
-            for (auto&& [name, type] : ns.second.types) {
-                //if (is_exclusive_to(type) && !_include_exclusive)
-                //{
-                //	std::cout << "Skipping exlusive type " << type.TypeNamespace() << "." << type.TypeName() << std::endl;
-                //	continue;
-                //}
+            auto type_name = std::string(type.TypeNamespace()) + "." + std::string(type.TypeName());
+            _manifest->record(type_name, type_fingerprint(type), file);
 
-                //if (has_attribute(type, "Windows.Foundation.Metadata", "WebHostHiddenAttribute") && !_allow_webhosthidden)
-                //{
-                //	std::cout << "Skipping WebHostHidden type " << type.TypeNamespace() << "." << type.TypeName() << std::endl;
-                //	continue; // no JS here
-                //}
+            auto guard{ _generic_args.push(type.GenericParam()) };
+            {
+                auto span = trace("do_write", type_name);
+                do_write(type);
+            }
 
-                if (!should_project_type(type)) {
-                    std::cout << "Skipping type " << type.TypeNamespace() << "." << type.TypeName() << std::endl;
-                    continue;
+            _stats->count_type(ns.name, get_category(type));
+            auto body = _out.str();
+            _out.str("");
+
+            if (_layout == output_layout::bundle) {
+                auto span = trace("write_import", type_name);
+                for (auto&& imported_type : _importedTypes) {
+                    if (!bundled(imported_type))
+                        module.external.insert(imported_type);
+                    else
+                        write_import(imported_type);
                 }
 
-                auto type_name = std::string(type.TypeNamespace()) + "." + std::string(type.TypeName());
-                auto file_name = std::string{ type.TypeName() } + ".ts";
-                auto guard{ _generic_args.push(type.GenericParam()) };
-                first_pass = true;
+                module.types.push_back({ type, _out.str(), std::move(body) });
+                _out.str("");
+            }
+            else {
+                if (!module.body.empty())
+                    module.body += "\n";
 
-                do_write(type);
+                module.body += body;
+                imported.merge(_importedTypes);
+            }
 
-                std::filesystem::path& fpath{ _path };
-                fpath.append(file_name);
-                if (std::filesystem::exists(fpath) && std::filesystem::file_size(fpath) > 0) {
-                    char header[3];
+            _importedTypes.clear();
+        }
 
-                    _out.open(fpath, std::fstream::in);
-                    _out.read(header, sizeof(header));
-                    header[2] = 0;
+        {
+            auto span = trace("write_import", ns.name);
+            for (auto&& imported_type : imported) {
+                write_import(imported_type);
+            }
+        }
 
-                    if (strcmp(header, "//") != 0) {
-                        _out.close();
-                        fpath.replace_extension(".gen.ts");
-                    }
-                }
+        module.imports = _out.str();
+        _out.str("");
+        return module;
+    }
 
-                _out.open(fpath, std::fstream::out | std::fstream::trunc);
+    // the types of `ns` in an order one module can define them in, every class after the class it extends
+    std::vector<TypeDef> ordered_types(namespace_node const& ns) {
+        std::vector<TypeDef> ordered;
+        std::set<std::pair<database const*, uint32_t>> placed;
+        for (auto&& [name, type] : ns.members->types) {
+            // the bases that aren't placed yet, walked up to the first one that is or that's elsewhere
+            std::vector<TypeDef> chain;
+            for (std::optional<TypeDef> t = type; t && t->TypeNamespace() == ns.name && placed.emplace(&t->get_database(), t->index()).second; t = projected_base(*t)) {
+                chain.push_back(*t);
+            }
 
-                write_header();
+            ordered.insert(ordered.end(), chain.rbegin(), chain.rend());
+        }
 
-                if (_importedTypes.size() != 0) {
-                    for (auto&& imported_type : _importedTypes) {
-                        if (imported_type != type_name)
-                            write_import(imported_type);
-                    }
+        return ordered;
+    }
 
-                    _out << std::endl;
+    // the class `type` extends, when that's projected into this root too
+    std::optional<TypeDef> projected_base(TypeDef const& type) {
+        if (get_category(type) != category::class_type || !type.Extends())
+            return {};
+
+        auto semantics = get_type_semantics(type.Extends());
+        auto base = std::get_if<type_definition>(&semantics);
+        if (!base)
+            return {};
+
+        auto ns = _namespaces->find(base->TypeNamespace());
+        if (!ns || !ns->projected || !ns->members || !should_project_type(*base))
+            return {};
+
+        return *base;
+    }
+
+    // true when every type in `ns` was last written from the same metadata, their manifest entries are carried over
+    bool namespace_unchanged(namespace_node const& ns) {
+        bool unchanged = true;
+        uint64_t types = 0;
+        for (auto&& [name, type] : ns.members->types) {
+            if (!should_project_type(type))
+                continue;
+
+            // a type that moved in or out of a module of its own has to be written where it is now
+            auto type_name = std::string(type.TypeNamespace()) + "." + std::string(type.TypeName());
+            auto file = _layout == output_layout::bundle ? bundle_path() : _sink->resolve(ns.path / (std::string(module_of(ns, type.TypeName())) + extension()));
+            unchanged = _manifest->unchanged(type_name, type_fingerprint(type), *_sink, file) && unchanged;
+            types++;
+        }
+
+        if (unchanged)
+            _stats->count(run_stats::counter::unchanged_types, types);
+
+        return unchanged;
+    }
+
+    bool bundle_unchanged() {
+        bool unchanged = true;
+        _namespaces->visit([&](namespace_node const& ns) {
+            if (ns.projected && ns.members)
+                unchanged = namespace_unchanged(ns) && unchanged;
+        });
+
+        return unchanged;
+    }
+
+    std::filesystem::path bundle_path() const {
+        return _sink->resolve(_basePath / ("index" + extension()));
+    }
+
+    // whether `type_name` is projected into the bundle, rather than imported into it
+    bool bundled(std::string const& type_name) const {
+        auto ns = _namespaces->find(std::string_view(type_name).substr(0, type_name.rfind('.')));
+        return ns && ns->projected && ns->members;
+    }
+
+    void write_type_files(namespace_node const& ns) {
+        auto span = trace("namespace", ns.name);
+        _current = &ns;
+
+        for (auto&& [name, type] : ns.members->types) {
+            if (!should_project_type(type)) {
+                std::cout << "Skipping type " << type.TypeNamespace() << "." << type.TypeName() << std::endl;
+                _stats->count(run_stats::counter::skipped_types);
+                continue;
+            }
+
+            auto type_name = std::string(type.TypeNamespace()) + "." + std::string(type.TypeName());
+            auto fingerprint = type_fingerprint(type);
+            if (_manifest->unchanged(type_name, fingerprint, *_sink)) {
+                _stats->count(run_stats::counter::unchanged_types);
+                continue;
+            }
+
+            write_type_file(ns, type, type_name, fingerprint);
+        }
+    }
+
+    void write_type_file(namespace_node const& ns, TypeDef const& type, std::string const& type_name, uint64_t fingerprint) {
+        auto file_name = std::string{ type.TypeName() } + extension();
+        auto guard{ _generic_args.push(type.GenericParam()) };
+
+        _current_module = type.TypeName();
+        _path = _sink->resolve(ns.path / file_name);
+        _manifest->record(type_name, fingerprint, _path);
+
+        // the body is emitted first so we know what it references, then the header and the
+        // imports are put in front of it
+        {
+            auto span = trace("do_write", type_name);
+            do_write(type);
+        }
+
+        _stats->count_type(ns.name, get_category(type));
+        auto body = _out.str();
+        _out.str("");
+
+        write_header();
+
+        if (_importedTypes.size() != 0) {
+            auto span = trace("write_import", type_name);
+            for (auto&& imported_type : _importedTypes) {
+                if (imported_type != type_name)
+                    write_import(imported_type);
+            }
+
+            _out << std::endl;
+        }
+
+        _out << body;
+
+        _sink->stage(_path, _out.str());
+        _out.str("");
+        _importedTypes.clear();
+    }
+
+    // A class can only be defined once the module of the class it extends has run, and ES modules
+    // that import each other run one of them first. When bases cross back and forth between
+    // namespaces, the classes doing so and everything they derive from get a module of their own,
+    // so no namespace module needs another in the cycle to have run.
+    std::shared_ptr<std::set<std::string> const> split_cycles() {
+        // the namespaces each one needs to have run, through the classes in it
+        std::map<namespace_node const*, std::set<namespace_node const*>> edges;
+        std::vector<std::pair<TypeDef, TypeDef>> crossings; // a class and its base in another namespace
+        _namespaces->visit([&](namespace_node const& ns) {
+            if (!ns.projected || !ns.members)
+                return;
+
+            for (auto&& [name, type] : ns.members->types) {
+                if (!should_project_type(type))
+                    continue;
+
+                auto base = projected_base(type);
+                if (base && base->TypeNamespace() != ns.name) {
+                    edges[&ns].insert(_namespaces->find(base->TypeNamespace()));
+                    crossings.emplace_back(type, *base);
                 }
+            }
+        });
 
-                _stack.push_back(file_name);
+        auto components = strongly_connected(edges);
+        auto split = std::make_shared<std::set<std::string>>();
+        for (auto&& [type, base] : crossings) {
+            if (components[_namespaces->find(type.TypeNamespace())] != components[_namespaces->find(base.TypeNamespace())])
+                continue;
 
-                first_pass = false;
-                do_write(type);
-                pop();
+            for (std::optional<TypeDef> t = type; t; t = projected_base(*t)) {
+                if (!split->insert(std::string(t->TypeNamespace()) + "." + std::string(t->TypeName())).second)
+                    break;
             }
         }
 
-        while (!_stack.empty()) {
-            pop();
+        return split;
+    }
+
+    // numbers the strongly connected components of `edges`, namespaces in the same cycle share a number
+    static std::map<namespace_node const*, size_t> strongly_connected(std::map<namespace_node const*, std::set<namespace_node const*>> const& edges) {
+        struct visit_state {
+            size_t index;
+            size_t low;
+            bool on_stack;
+        };
+
+        std::map<namespace_node const*, visit_state> states;
+        std::vector<namespace_node const*> stack;
+        std::map<namespace_node const*, size_t> components;
+        size_t next = 0;
+
+        std::function<void(namespace_node const*)> connect = [&](namespace_node const* node) {
+            auto& state = states[node];
+            state = { next, next, true };
+            next++;
+            stack.push_back(node);
+
+            if (auto it = edges.find(node); it != edges.end()) {
+                for (auto target : it->second) {
+                    auto found = states.find(target);
+                    if (found == states.end()) {
+                        connect(target);
+                        state.low = std::min<size_t>(state.low, states[target].low);
+                    }
+                    else if (found->second.on_stack) {
+                        state.low = std::min<size_t>(state.low, found->second.index);
+                    }
+                }
+            }
+
+            if (state.low != state.index)
+                return;
+
+            auto component = components.size();
+            namespace_node const* member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                states[member].on_stack = false;
+                components[member] = component;
+            } while (member != node);
+        };
+
+        for (auto&& [node, targets] : edges) {
+            if (!states.count(node))
+                connect(node);
         }
+
+        return components;
+    }
+
+    // whether `type` was split out of a cycle between namespace modules
+    bool split(TypeDef const& type) const {
+        return _split && _split->count(std::string(type.TypeNamespace()) + "." + std::string(type.TypeName()));
+    }
+
+    // the module in the directory of `ns` that `type_name` is defined in
+    std::string_view module_of(namespace_node const& ns, std::string_view type_name) const {
+        if (_layout == output_layout::per_type)
+            return type_name;
+
+        if (_split && _split->count(std::string(ns.name) + "." + std::string(type_name)))
+            return type_name;
+
+        return namespace_module_name;
     }
 
     void do_write(TypeDef type) {
@@ -295,17 +1026,13 @@ public:
     }
 
     void write_header() {
-        auto&& assembly = _cache.databases().front().Assembly.begin(); // grab the first assembly
+        auto&& assembly = _root->db->Assembly.begin();
         auto ver = assembly.Version();
-        auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-
-        char str[26];
-        ctime_s(str, sizeof str, &time);
 
         _out << "// --------------------------------------------------" << std::endl;
         _out << "// <auto-generated>" << std::endl;
         _out << "//     This code was generated by tswinrt." << std::endl;
-        _out << "//     Generated from " << assembly.Name() << " " << ver.MajorVersion << "." << ver.MinorVersion << "." << ver.BuildNumber << "." << ver.RevisionNumber << " at " << str;
+        _out << "//     Generated from " << assembly.Name() << " " << ver.MajorVersion << "." << ver.MinorVersion << "." << ver.BuildNumber << "." << ver.RevisionNumber << " at " << _timestamp;
         _out << "// </auto-generated>" << std::endl;
         _out << "// --------------------------------------------------" << std::endl;
         _out << std::endl;
@@ -319,12 +1046,12 @@ public:
 
     void write_enum(TypeDef type) {
         uint32_t val = 0;
-        bool is_flags = has_attribute(type, "System", "FlagsAttribute");
+        bool is_flags = has_attribute(type, known_attribute::flags);
 
-        _out << "export enum " << type.TypeName() << " {" << std::endl;
+        _out << "export " << declare() << "enum " << type.TypeName() << " {" << std::endl;
         for (auto field : type.FieldList()) {
             if (auto constant = field.Constant()) {
-                _out << whitespace(1) << normalise_member_name(field.Name());
+                _out << whitespace(1) << member_name(field);
 
                 uint32_t constant_val = is_flags ? constant.ValueUInt32() : constant.ValueInt32();
                 if (constant_val != val || is_flags) {
@@ -353,7 +1080,7 @@ public:
             if (field.Flags().Static())
                 _out << "static ";
 
-            _out << normalise_member_name(field.Name()) << ": " << projection_type_name(semantics, false, true) << ";" << std::endl;
+            _out << member_name(field) << ": " << projection_type_name(semantics, false, true) << ";" << std::endl;
         }
 
         _out << "}" << std::endl;
@@ -377,18 +1104,18 @@ public:
         auto name = type_name(type, false);
         auto base_semantics = get_type_semantics(type.Extends());
 
-        if (_generate_shims && _enable_decorators) {
+        if (_generate_shims && _enable_decorators && !_declarations) {
             _importedTypes.insert("Windows.Foundation.Interop.GenerateShim");
             _out << "@GenerateShim('" << type.TypeNamespace() << "." << type.TypeName() << "')" << std::endl;
         }
 
-        _out << "export class " << name;
+        _out << "export " << declare() << "class " << name;
         write_inhereted_types(type, base_semantics);
         _out << " { " << std::endl;
 
         write_properties(type);
-        write_ctors(type, true);
-        write_method_list(type, true);
+        write_ctors(type, !_declarations);
+        write_method_list(type, !_declarations);
         write_event_list(type, false);
 
         _out << "}" << std::endl;
@@ -405,6 +1132,32 @@ public:
         _out << ") => " << return_type_name << ";" << std::endl;
     }
 
+#ifdef _WIN32
+    // activates the type, or its statics, and calls the getter of a property
+    HRESULT invoke_getter(TypeDef const& type, MethodDef const& getter, IInspectable** instance, bool is_static) {
+        std::vector<void*> args;
+        interop::call_invoker invoker;
+        GUID value;
+
+        std::cout << (is_static ? "Calling function " : "Calling instance function ") << type.TypeNamespace() << "." << type.TypeName() << "#" << getter.Name() << ": ";
+        std::cout.flush();
+
+        HRESULT hr;
+        {
+            auto span = trace("invoke", _trace ? std::string(type.TypeNamespace()) + "." + std::string(type.TypeName()) + "#" + std::string(getter.Name()) : std::string{});
+            hr = invoker.invoke(getter, instance, (void*)&value, args);
+        }
+
+        std::wcout << _com_error(hr).ErrorMessage() << std::endl;
+        std::wcout.flush();
+
+        if (FAILED(hr))
+            _stats->count(run_stats::counter::failed_invocations);
+
+        return hr;
+    }
+#endif
+
     void write_inhereted_types(TypeDef type, type_semantics semantics) {
         auto delimiter{ " extends " };
         auto write_delimiter = [&]() {
@@ -420,8 +1173,8 @@ public:
         if (get_category(type) != category::interface_type)
             delimiter = " implements ";
 
-        for (auto&& iface : type.InterfaceImpl()) {
-            for_typedef(get_type_semantics(iface.Interface()), [&](auto type) {
+        for (auto&& iface : get_interfaces(type).declared) {
+            for_typedef(iface, [&](auto type) {
                 if (!(is_exclusive_to(type) && !_include_exclusive)) {
                     write_delimiter();
                     _out << type_name(type, false);
@@ -431,12 +1184,14 @@ public:
     }
 
     void write_properties(TypeDef& type, bool is_interface = false) {
+#ifdef _WIN32
         IInspectable* instance = nullptr;
         IInspectable* statics = nullptr;
+        bool failed = false;
+#endif
         for (auto prop : type.PropertyList()) {
             auto semantics = get_type_semantics(prop.Type().Type());
             auto [getter, setter] = get_property_methods(prop);
-            GUID value;
 
             //if (!is_interface && (getter && !setter))
             //{
@@ -462,50 +1217,35 @@ public:
             //else
             //{
             _out << whitespace(1);
-            std::vector<void*> args;
-            interop::call_invoker invoker;
 
-            if ((getter && getter.Flags().Static()) || (setter && setter.Flags().Static()) && !this->first_pass) {
+            bool is_static = (getter && getter.Flags().Static()) || (setter && setter.Flags().Static());
+            if (is_static)
                 _out << "static ";
-                
-                if (!is_interface) {
-                    std::cout << "Calling function " << type.TypeNamespace() << "." << type.TypeName() << "#" << getter.Name() << ": ";
-                    std::cout.flush();
-                    auto hr = invoker.invoke(getter, &statics, (void*)&value, args);
-                    std::wcout << _com_error(hr).ErrorMessage() << std::endl;
-                    std::wcout.flush();
 
-                    if (FAILED(hr)) {
-
-                    }
-                }
-            }
-            else if (!is_interface && has_attribute(type, "Windows.Foundation.Metadata", "ActivatableAttribute") && !this->first_pass) {
-                std::cout << "Calling instance function " << type.TypeNamespace() << "." << type.TypeName() << "#" << getter.Name() << ": ";
-                std::cout.flush();
-                auto hr = invoker.invoke(getter, &instance, (void*)&value, args);
-                std::wcout << _com_error(hr).ErrorMessage() << std::endl;
-                std::wcout.flush();
-
-                if (FAILED(hr)) {
-
-                }
-            }
+#ifdef _WIN32
+            if (!is_interface && (is_static || has_attribute(type, known_attribute::activatable)))
+                failed |= FAILED(invoke_getter(type, getter, is_static ? &statics : &instance, is_static));
+#endif
 
             if ((getter) && !(setter)) {
                 _out << "readonly ";
             }
 
-            _out << normalise_member_name(prop.Name()) << ": " << projection_type_name(semantics, false, true);
+            _out << member_name(prop) << ": " << projection_type_name(semantics, false, true);
             if (prop.Type().Type().is_szarray())
                 _out << "[]";
 
-            if (!is_interface)
+            if (!is_interface && !_declarations)
                 _out << " = null";
 
             _out << ";" << std::endl;
             //}
         }
+
+#ifdef _WIN32
+        if (failed)
+            _stats->count(run_stats::counter::failing_types);
+#endif
     }
 
     void write_ctors(TypeDef& type, bool include_signature) {
@@ -522,21 +1262,23 @@ public:
 
         int32_t max_dist = 0;
         for (auto& ctor : ctors) {
-            max_dist = max(distance(ctor.ParamList()), max_dist);
+            max_dist = (std::max)(static_cast<int32_t>(distance(ctor.ParamList())), max_dist);
         }
 
         int32_t min_dist = max_dist;
         for (auto& ctor : ctors) {
-            min_dist = min(min_dist, distance(ctor.ParamList()));
+            min_dist = (std::min)(min_dist, static_cast<int32_t>(distance(ctor.ParamList())));
         }
 
         if (max_dist == 0 && min_dist == 0)
             return;
 
+        // overloads need an implementation that takes all of them, a declaration has none to give
+        bool overloaded = ctors.size() != 1 && !_declarations;
         for (auto& ctor : ctors) {
             method_signature ctor_sig{ ctor };
             auto dist = distance(ctor.ParamList());
-            if (ctors.size() != 1)
+            if (overloaded)
                 _out << whitespace(1) << "// constructor(";
             else
                 _out << whitespace(1) << "constructor(";
@@ -551,7 +1293,7 @@ public:
                 auto param_type = get_type_semantics(param.second->Type());
                 auto param_type_name = projection_type_name(param_type, false, true);
 
-                _out << normalise_member_name(param.first.Name()) << ": " << param_type_name;
+                _out << member_name(param.first) << ": " << param_type_name;
 
                 /*if (dist == max_dist)
 				{
@@ -571,7 +1313,7 @@ public:
             }
         }
 
-        if (ctors.size() != 1)
+        if (overloaded)
             _out << whitespace(1) << "constructor(...args) { }" << std::endl;
     }
 
@@ -596,18 +1338,18 @@ public:
             std::string return_type_name = get_return_type_name(method_sig, out_params);
             bool should_throw = return_type_name != "void";
 
-            auto overload_attribute = get_attribute(method, "Windows.Foundation.Metadata", "OverloadAttribute");
+            bool overload_attribute = has_attribute(method, known_attribute::overload);
             if (overload_attribute) {
-                auto sig = std::get<ElemSig>(overload_attribute.Value().FixedArgs()[0].value);
-                name = std::get<std::string_view>(sig.value);
+                name = attributes(method).overload;
 
-                if (!first_pass)
-                    std::cout << "Overloading " << type.TypeNamespace() << "." << type.TypeName() << "#" << method.Name() << " -> " << type.TypeNamespace() << "." << type.TypeName() << "#" << name << std::endl;
+                std::cout << "Overloading " << type.TypeNamespace() << "." << type.TypeName() << "#" << method.Name() << " -> " << type.TypeNamespace() << "." << type.TypeName() << "#" << name << std::endl;
+                _stats->count(run_stats::counter::overloaded_methods);
             }
 
-            auto method_name = normalise_member_name(name);
+            std::string method_name = overload_attribute ? normalise_member_name(name) : std::string(member_name(method));
             if (methods.find(method_name) != methods.end()) {
                 std::cout << "Skipping non-uniquely overloaded method " << type.TypeNamespace() << "." << type.TypeName() << "#" << name << std::endl;
+                _stats->count(run_stats::counter::dropped_overloads);
                 continue;
             }
 
@@ -696,7 +1438,7 @@ public:
                 ss << ", ";
             }
 
-            ss << normalise_member_name(param.first.Name()) << ": " << projection_type_name(get_type_semantics(param.second->Type()), false, true);
+            ss << member_name(param.first) << ": " << projection_type_name(get_type_semantics(param.second->Type()), false, true);
             if (param.second->Type().is_szarray())
                 ss << "[]";
 
@@ -718,14 +1460,22 @@ public:
         for (auto& event : type.EventList()) {
             auto event_type = get_type_semantics(event.EventType());
             auto event_type_name = type_name(event_type, false);
-            auto event_name = normalise_member_name(event.Name());
-            auto array_name = "__" + normalise_member_name(event.Name());
+            auto event_name = std::string(member_name(event));
+            auto array_name = "__" + event_name;
             auto [add, remove] = get_event_methods(event);
 
             std::transform(event_name.begin(), event_name.end(), event_name.begin(), ::tolower);
 
             std::string this_str = "this.";
 
+            // declared classes only say the handler can be set, the sets of handlers are an implementation detail
+            if (_declarations && !is_interface) {
+                bool is_static = (add && add.Flags().Static()) || (remove && remove.Flags().Static());
+                (is_static ? any_static : any_nonstatic) = true;
+                _out << whitespace(1) << (is_static ? "static " : "") << "set on" << event_name << "(handler: " << event_type_name << ");" << std::endl;
+                continue;
+            }
+
             if (!is_interface)
                 _out << whitespace(1) << "private ";
             if ((add && add.Flags().Static()) || (remove && remove.Flags().Static())) {
@@ -783,6 +1533,11 @@ public:
             return;
         }
 
+        if (_declarations) {
+            _out << ": void;" << std::endl;
+            return;
+        }
+
         _out << " {" << std::endl;
         _out << whitespace(2) << "switch (name) {" << std::endl;
 
@@ -794,8 +1549,8 @@ public:
         for (auto& event : type.EventList()) {
             auto event_type = get_type_semantics(event.EventType());
             auto event_type_name = type_name(event_type, false);
-            auto event_name = normalise_member_name(event.Name());
-            auto array_name = "__" + normalise_member_name(event.Name());
+            auto event_name = std::string(member_name(event));
+            auto array_name = "__" + event_name;
             auto [add, remove] = get_event_methods(event);
 
             if (((add && add.Flags().Static()) || (remove && remove.Flags().Static()))) {
@@ -840,15 +1595,14 @@ public:
             auto param_type = get_type_semantics(param.second->Type());
             auto& param_type_name = projection_type_name(param_type, false, true);
 
-            _out << normalise_member_name(param.first.Name()) << ": " << param_type_name;
+            _out << member_name(param.first) << ": " << param_type_name;
             if (param.second->Type().is_szarray() || param.second->Type().is_array())
                 _out << "[]";
         }
     }
 
     void write_import(const std::string& type_name, const std::string& name_override = "") {
-        auto type = _cache.find(type_name);
-        auto&& assembly = _cache.databases().front().Assembly.begin(); // grab the first assembly
+        auto type = _cache->find(type_name);
 
         if (static_cast<bool>(type) && !(should_project_type(type))) {
             // assign any to direct references to unprojected types
@@ -858,102 +1612,76 @@ public:
             // we assume non-existent types are synthesised after the fact
             // generally required for decorators
 
-            std::vector<std::string> type_bits = tokenise_string(type_name, "."); // split by .
-            std::string path_str;
-            std::string name = name_override.empty() ? type_bits.back() : name_override;
-
-            if (type_bits[0] == "Windows" && assembly.Name() != "Windows") {
-                path_str = "winrt/";
-                for (size_t i = 0; i < type_bits.size(); i++) {
-                    if (i != 0)
-                        path_str += "/";
-
-                    path_str += type_bits[i];
-                }
-            }
-            else {
-                std::filesystem::path current_path = std::filesystem::absolute(_path).parent_path();
-                std::filesystem::path abs_path(_basePath);
-                for (auto type_bit : type_bits) {
-                    abs_path.append(type_bit);
-                }
+            auto separator = type_name.rfind('.');
+            auto ns_name = std::string_view(type_name).substr(0, separator);
+            auto type_part = std::string_view(type_name).substr(separator + 1);
+            std::string name = name_override.empty() ? std::string(type_part) : name_override;
 
-                auto path = std::filesystem::relative(abs_path, current_path);
-                path_str = path.string();
-                std::replace(path_str.begin(), path_str.end(), '\\', '/');
+            auto ns = _namespaces->find(ns_name);
+            if (!ns)
+                throw_invalid("'", type_name, "' is not in a known namespace");
 
-                if (path_str.rfind('.', 0) != 0) {
-                    path_str = "./" + path_str;
-                }
-            }
+            // a namespace module already has the types of its namespace in scope
+            if (_layout != output_layout::per_type && ns == _current && module_of(*ns, type_part) == _current_module)
+                return;
 
             // remove generic names
             auto index = name.find('`');
             if (index != std::string::npos)
                 name = name.substr(0, index);
 
-            _out << "import { " << name << " } from \"" << path_str << "\";" << std::endl;
+            // inside the bundle, other namespaces are reached through their namespace blocks
+            if (_layout == output_layout::bundle && ns->projected && ns->members) {
+                _out << "import " << name << " = " << ns->name << "." << name << ";" << std::endl;
+                return;
+            }
+
+            _out << "import { " << name << " } from \"" << module_path(*ns, type_part) << "\";" << std::endl;
         }
     }
 
+    // the module `type_name` in `ns` is imported from, relative to the current namespace
+    std::string module_path(namespace_node const& ns, std::string_view type_name) {
+        auto&& assembly = _root->db->Assembly.begin();
+        auto module = _layout == output_layout::bundle ? type_name : module_of(ns, type_name);
+
+        std::string path_str;
+        auto owner = _projections->owner(ns.name);
+        if (owner && owner != _root) {
+            // projected by another input of this run, into its own root next to ours
+            auto target = owner->namespaces->find(ns.name)->path / std::string(module);
+            path_str = target.lexically_relative(_current->path).generic_string();
+            if (path_str.substr(0, 3) != "../")
+                path_str = "./" + path_str;
+        }
+        else if (ns.name.substr(0, ns.name.find('.')) == "Windows" && assembly.Name() != "Windows") {
+            path_str = "winrt/" + ns.module_path + "/" + std::string(module);
+        }
+        else {
+            path_str = namespace_trie::relative_path(*_current, ns, module);
+        }
 
-    std::string whitespace(size_t depth) {
-        return std::string(depth * 4, ' ');
+        return path_str;
     }
 
-    void write_pop() {
-        if (_out.is_open())
-            _out.close();
-        _path = _path.parent_path();
-    }
 
-    void pop() {
-        _importedTypes.clear();
-        _stack.pop_back();
-        write_pop();
+    std::string whitespace(size_t depth) {
+        return std::string(depth * 4, ' ');
     }
 
-    template <typename T>
-    bool has_attribute(T const& row, std::string_view const& type_namespace, std::string_view const& type_name) {
-        return static_cast<bool>(get_attribute(row, type_namespace, type_name));
+    std::string extension() const {
+        return _declarations ? ".d.ts" : ".ts";
     }
 
-    std::vector<std::string> tokenise_string(std::string s, std::string delimiter) {
-        std::vector<std::string> tokens;
-        size_t position = 0;
-        while ((position = s.find(delimiter)) != std::string::npos) {
-            tokens.push_back(s.substr(0, position));
-            s.erase(0, position + delimiter.length());
-        }
-
-        if (!s.empty())
-            tokens.push_back(s);
-
-        return tokens;
+    // the top level of a declaration file says what's declared, inside the bundle's namespaces it's implied
+    std::string_view declare() const {
+        return _declarations && _layout != output_layout::bundle ? "declare "sv : ""sv;
     }
 
-    std::string normalise_member_name(const std::string_view& n) {
-        std::string name{ n };
-        if (isupper(name[0])) {
-            size_t i = 0;
-            for (; i < name.length(); i++) {
-                if (name[i] == '_' || islower(name[i])) {
-                    break;
-                }
-            }
-
-            std::string start = name.substr(0, i);
-            std::transform(start.begin(), start.end(), start.begin(), ::tolower);
-            std::string end = name.substr(i);
-
-            return start + end;
-        }
-
-        if (_banned_identifiers.find(name) != _banned_identifiers.end()) {
-            name = "__" + name;
-        }
-
-        return name;
+    std::string normalise_member_name(std::string_view const& name) {
+        std::string normalised;
+        ::normalise_member_name(name, normalised);
+        return normalised;
     }
 
     template <typename TAction, typename TResult = std::invoke_result_t<TAction, type_definition>>
@@ -977,41 +1705,33 @@ public:
     std::string typedef_name(type_definition const& type, bool relative, bool fullyProjected = false) {
 
         if (fullyProjected) {
-            if (_namespace_type_map.find(type.TypeNamespace()) != _namespace_type_map.end()) {
-                auto ns_map = _namespace_type_map[type.TypeNamespace()];
-                if (ns_map.find(type.TypeName()) != ns_map.end()) {
-                    return std::string(ns_map[type.TypeName()]);
-                }
-            }
+            auto mapping = type_map::current().find(type.TypeNamespace(), type.TypeName());
+            if (mapping && !mapping->projected_name.empty())
+                return std::string(mapping->projected_name);
         }
 
-        _importedTypes.insert(std::string(type.TypeNamespace()) + "." + std::string(type.TypeName()));
+        add_import(std::string(type.TypeNamespace()) + "." + std::string(type.TypeName()));
 
-        std::stringstream s;
-        std::vector<std::string> type_bits = tokenise_string(std::string(type.TypeNamespace()), ".");
         std::string name{ type.TypeName() };
         auto index = name.find('`');
         if (index != std::string::npos)
-            name = name.substr(0, index);
+            name.resize(index);
 
         if (!relative)
             return name;
 
-        type_bits.push_back(name);
-
-        size_t i = 0;
-        while (i < _stack.size() && i < type_bits.size() && type_bits[i] == _stack[i])
-            i++;
-
-        for (size_t x = i; x < type_bits.size(); x++) {
-            s << type_bits[x];
-            if (x != type_bits.size() - 1)
-                s << ".";
+        std::string s;
+        auto ns = _namespaces->find(type.TypeNamespace());
+        for (auto&& segment : namespace_trie::segments_below(namespace_trie::common_ancestor(*_current, *ns), *ns)) {
+            s += segment;
+            s += ".";
         }
 
-        s << generic_type_params(type);
+        s += name;
 
-        return s.str();
+        s += generic_type_params(type);
+
+        return s;
     }
 
     std::string fundamental_type_name(fundamental_type const& type) {
@@ -1031,39 +1751,40 @@ public:
     }
 
     std::string generic_type_params(TypeDef const& type) {
-        std::stringstream s;
+        std::string s;
         size_t dist = distance(type.GenericParam());
         if (dist == 0)
-            return s.str();
-        s << "<";
+            return s;
+        s += "<";
         for (size_t i = 0; i < dist; i++) {
             if (i > 0)
-                s << ", ";
+                s += ", ";
 
-            s << projection_type_name(get_generic_arg(i), false);
+            s += projection_type_name(get_generic_arg(i), false);
         }
-        s << ">";
+        s += ">";
 
-        return s.str();
+        return s;
     }
 
     std::string generic_type_instance_name(generic_type_instance const& type, bool relative, bool fullyProjected) {
-        std::stringstream s;
+        std::string s;
         auto guard{ push_generic_args(type) };
         auto first = true;
 
         if (fullyProjected && type.generic_type.TypeName() == "IReference`1") {
-            return std::string(projection_type_name(get_generic_arg(0), relative, true)) + " | null";
+            return projection_type_name(get_generic_arg(0), relative, true) + " | null";
         }
 
-        s << projection_type_name(type.generic_type, relative) << "<";
-        for (auto x : type.generic_args) {
+        s += projection_type_name(type.generic_type, relative);
+        s += "<";
+        for (auto&& x : type.generic_args()) {
             if (!first)
-                s << ", ";
+                s += ", ";
 
             try {
                 // TODO: figure out why this breaks
-                s << projection_type_name(x, relative);
+                s += projection_type_name(x, relative);
             }
             catch (const std::exception&) {
                 break;
@@ -1072,12 +1793,57 @@ public:
             first = false;
         }
 
-        s << ">";
+        s += ">";
 
-        return s.str();
+        return s;
     }
 
-    std::string projection_type_name(type_semantics const& s, bool relative, bool fullyProjected = false) {
+    /// Returns the projected name of `s`, memoized per emission context.
+    ///
+    /// A name depends on the semantics, the generic arguments in scope and the flags, so that's what
+    /// the cache is keyed on. Projecting a name also imports every type it mentions; a cache hit
+    /// replays those imports so the file being written still gets them.
+    std::string const& projection_type_name(type_semantics const& s, bool relative, bool fullyProjected = false) {
+        std::string key;
+        key.reserve(64);
+        key.push_back(fullyProjected ? 'f' : 'p');
+
+        // relative names depend on where we're writing from, they aren't worth keeping
+        if (relative || !append_name_key(s, key)) {
+            return *_interned_names.insert(uncached_projection_type_name(s, relative, fullyProjected)).first;
+        }
+
+        auto it = _projected_names.find(key);
+        if (it != _projected_names.end()) {
+            for (auto&& import : it->second.imports) {
+                add_import(import);
+            }
+
+            return it->second.name;
+        }
+
+        _import_frames.emplace_back();
+        std::string name;
+        try {
+            name = uncached_projection_type_name(s, relative, fullyProjected);
+        }
+        catch (...) {
+            _import_frames.pop_back();
+            throw;
+        }
+
+        auto imports = std::move(_import_frames.back());
+        _import_frames.pop_back();
+
+        // whatever this name imported is part of the name we're nested in, if any
+        if (!_import_frames.empty()) {
+            _import_frames.back().insert(_import_frames.back().end(), imports.begin(), imports.end());
+        }
+
+        return _projected_names.emplace(std::move(key), projected_name{ std::move(name), std::move(imports) }).first->second.name;
+    }
+
+    std::string uncached_projection_type_name(type_semantics const& s, bool relative, bool fullyProjected) {
         return call(
             s,
             [&](object_type) { return std::string("any"); },
@@ -1090,6 +1856,70 @@ public:
             [&](fundamental_type const& type) { return fundamental_type_name(type); });
     }
 
+    /// Appends a key to `key` that's equal for two semantics exactly when they project to the same
+    /// name. Generic parameters are resolved against the arguments in scope, the same way the
+    /// projection resolves them, so the key captures the generic context as well.
+    bool append_name_key(type_semantics const& s, std::string& key) {
+        auto append_row = [&](auto const& row) {
+            auto db = &row.get_database();
+            auto index = row.index();
+            key.append(reinterpret_cast<char const*>(&db), sizeof(db));
+            key.append(reinterpret_cast<char const*>(&index), sizeof(index));
+        };
+
+        key.push_back(static_cast<char>(s.index()));
+        return call(
+            s,
+            [&](type_definition const& type) {
+                append_row(type);
+                return true;
+            },
+            [&](generic_type_instance const& type) {
+                // a closed instantiation is the same wherever it's used, its node says it all
+                if (!type.instantiation->open) {
+                    key.append(reinterpret_cast<char const*>(&type.instantiation), sizeof(type.instantiation));
+                    return true;
+                }
+
+                // the arguments are named with the instance's own frame pushed, so they're keyed the same way
+                auto guard{ push_generic_args(type) };
+                append_row(type.generic_type);
+                key.push_back(static_cast<char>(type.generic_args().size()));
+                for (auto&& arg : type.generic_args()) {
+                    if (!append_name_key(arg, key))
+                        return false;
+                }
+
+                return true;
+            },
+            [&](generic_type_index const& var) {
+                try {
+                    auto scope = get_generic_arg_scope(var.index);
+                    return append_name_key(scope.first, key);
+                }
+                catch (const std::exception&) {
+                    return false; // nothing in scope, let the projection deal with it
+                }
+            },
+            [&](generic_type_param const& param) {
+                append_row(param);
+                return true;
+            },
+            [&](fundamental_type const& type) {
+                key.push_back(static_cast<char>(type));
+                return true;
+            },
+            [&](auto) {
+                return true;
+            });
+    }
+
+    void add_import(std::string const& type_name) {
+        _importedTypes.insert(type_name);
+        if (!_import_frames.empty())
+            _import_frames.back().push_back(type_name);
+    }
+
     std::string type_name(type_semantics const& semantics, bool relative) {
         return for_typedef(semantics, [&](auto type) {
             std::stringstream s;
@@ -1099,16 +1929,176 @@ public:
     }
 
 private:
-    cache _cache{};
-    std::set<std::string> _namespaces{};
+    struct worker_t {};
+
+    // whether `db` was given as an input, a directory projects every winmd in it
+    static bool is_input(database const& db, settings const& settings) {
+        auto file = std::filesystem::absolute(db.path()).lexically_normal();
+        for (auto&& input : settings.input) {
+            auto relative = file.lexically_relative(std::filesystem::absolute(input).lexically_normal());
+            if (!relative.empty() && *relative.begin() != "..")
+                return true;
+        }
+
+        return false;
+    }
+
+    // adopts the tables of every database that the last run of --watch kept, or that has a snapshot
+    // matching its winmd, returns the ones to save a snapshot of
+    std::vector<std::pair<database const*, snapshot_file>> load_tables(std::filesystem::path const& directory, bool snapshots) {
+        std::vector<std::pair<database const*, snapshot_file>> unsaved;
+        for (auto&& db : _cache->databases()) {
+            snapshot_file file{ directory, db.path() };
+            if (!file.keyed())
+                continue;
+
+            _table_keys.emplace_back(&db, file.key());
+            auto retained = retained_tables().find(file.key());
+            if (retained != retained_tables().end()) {
+                snapshot_reader in{ retained->second, 0 };
+                adopt_tables(db, in);
+                _stats->count(run_stats::counter::tables_retained);
+                continue;
+            }
+
+            if (!snapshots)
+                continue;
+
+            try {
+                if (auto in = file.open()) {
+                    adopt_tables(db, *in);
+                    _stats->count(run_stats::counter::snapshots_loaded);
+                    continue;
+                }
+            }
+            catch (std::exception const& e) {
+                std::cout << "Ignoring snapshot of " << db.path() << ": " << e.what() << std::endl;
+            }
+
+            unsaved.emplace_back(&db, std::move(file));
+        }
+
+        return unsaved;
+    }
+
+    void adopt_tables(database const& db, snapshot_reader& in) {
+        // both tables are read before either is adopted, so a damaged snapshot leaves nothing behind
+        auto identifiers = std::make_unique<identifier_table>(db, in);
+        auto attributes = std::make_unique<attribute_table>(db, in);
+        database_index<identifier_table>::adopt(db, std::move(identifiers));
+        database_index<attribute_table>::adopt(db, std::move(attributes));
+    }
+
+    // the tables retain_indexes() kept, by snapshot_file::key()
+    static std::map<std::string, std::shared_ptr<mapped_file const>>& retained_tables() {
+        static std::map<std::string, std::shared_ptr<mapped_file const>> tables;
+        return tables;
+    }
+
+    // a run of --watch only projects the roots whose winmd changed. A reference that changed can
+    // change any of them, and a winmd that came or went changes which namespaces each one owns
+    void find_stale_roots(settings const& settings) {
+        _stale_roots.clear();
+        for (auto&& changed : settings.changed) {
+            auto root = std::find_if(_projections->roots.begin(), _projections->roots.end(), [&](projection_root const& root) {
+                return std::filesystem::absolute(root.db->path()).lexically_normal() == changed;
+            });
+
+            if (root == _projections->roots.end()) {
+                _stale_roots.clear();
+                return;
+            }
+
+            _stale_roots.insert(&*root);
+        }
+    }
+
+    // whether `root` is projected this run
+    bool stale(projection_root const& root) const {
+        return _stale_roots.empty() || _stale_roots.count(&root);
+    }
+
+    void save_snapshots(std::vector<std::pair<database const*, snapshot_file>> const& unsaved) {
+        for (auto&& [db, file] : unsaved) {
+            snapshot_writer out;
+            database_index<identifier_table>::get(*db).save(out);
+            database_index<attribute_table>::get(*db).save(out);
+
+            try {
+                file.save(out);
+            }
+            catch (std::exception const& e) {
+                // the next run just builds the tables again
+                std::cout << "Can't save snapshot of " << db->path() << ": " << e.what() << std::endl;
+            }
+        }
+    }
+
+    // makes `root` the assembly being projected
+    void select(projection_root const& root) {
+        _root = &root;
+        _namespaces = root.namespaces;
+        _basePath = root.path;
+        _path = root.path;
+        _current = &_namespaces->root();
+    }
+
+    // a span in the --trace timeline, free when there's no trace being taken
+    trace_log::span trace(std::string_view category, std::string_view name) {
+        return { _trace.get(), category, name };
+    }
+
+    // a worker shares the cache and configuration of its parent, but emits through its own context
+    writer(writer const& parent, worker_t) : _stats(parent._stats), _trace(parent._trace), _cache(parent._cache), _projections(parent._projections), _root(parent._root), _namespaces(parent._namespaces), _current(&parent._namespaces->root()), _path(parent._basePath), _basePath(parent._basePath), _out(), _timestamp(parent._timestamp), _filter(parent._filter), _layout(parent._layout), _declarations(parent._declarations), _jobs(1), _manifest(parent._manifest), _sink(parent._sink), _split(parent._split),
+                                            _enable_decorators(parent._enable_decorators), _generate_shims(parent._generate_shims), _include_exclusive(parent._include_exclusive), _allow_webhosthidden(parent._allow_webhosthidden) {
+    }
+
+    static std::shared_ptr<cache> load_cache(run_stats& stats, settings const& settings) {
+        auto phase = stats.phase("load metadata");
+
+        // references are loaded alongside the inputs, so types they define resolve the same way
+        auto files = settings.input;
+        files.insert(files.end(), settings.reference.begin(), settings.reference.end());
+        return std::make_shared<cache>(files);
+    }
+
+    std::shared_ptr<run_stats> _stats;
+    std::shared_ptr<trace_log> _trace;
+    std::filesystem::path _trace_path;
+    std::shared_ptr<cache> _cache;
+    std::shared_ptr<projection_set const> _projections;
+    std::set<projection_root const*> _stale_roots; // the roots to project, all of them when empty
+    std::vector<std::pair<database const*, std::string>> _table_keys;
+    projection_root const* _root = nullptr;
+    std::shared_ptr<namespace_trie const> _namespaces;
+    std::string _timestamp;
+    namespace_filter _filter;
+    output_layout _layout = output_layout::per_type;
+    bool _lazy_index = false;
+    bool _declarations = false; // .d.ts files, with no bodies and nothing that runs
+    uint32_t _jobs = 1;
+    std::shared_ptr<manifest> _manifest;
+    std::shared_ptr<output_sink> _sink;
+    std::shared_ptr<std::set<std::string> const> _split; // classes given their own module to break a cycle
+    std::map<namespace_node const*, namespace_module> _bundle;
+
+    // emission context, each worker has its own
     std::set<std::string> _importedTypes{};
-    std::vector<std::string> _stack{};
-    std::filesystem::path& _path;
+    namespace_node const* _current = nullptr;
+    std::string_view _current_module = namespace_module_name;
+    std::filesystem::path _path;
     std::filesystem::path _basePath;
-    std::fstream _out;
-    std::fstream _module;
+    std::ostringstream _out;
     generic_args _generic_args;
-    bool first_pass;
+
+    struct projected_name {
+        std::string name;
+        std::vector<std::string> imports;
+    };
+
+    std::unordered_map<std::string, projected_name> _projected_names;
+    std::unordered_set<std::string> _interned_names;
+    std::vector<std::vector<std::string>> _import_frames;
     bool _enable_decorators = true;
     bool _generate_shims = true;
     bool _include_exclusive = false;